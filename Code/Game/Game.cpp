@@ -169,6 +169,8 @@ void Game::onInput() {
     ImGui::SliderFloat3("Camera Rotation", (float*)&mCameraController->camera().transform().localRotation(), -360, 360);
     ImGui::End();
 
+    mChunkBenchmark.onGui();
+
     if(Input::Get().isKeyJustDown(KEYBOARD_F4)) {
       possessPlayer = !possessPlayer;
     }
@@ -198,6 +200,7 @@ void Game::onInput() {
       mPlayerRaycast.contact.block.reset(*air);
       mPlayerRaycast.contact.block.dirtyLight();
       mPlayerRaycast.contact.block.chunk->markSavePending();
+      mWorld->submitPlayerEdit(mPlayerRaycast.contact.block);
     }
   }
 
@@ -215,6 +218,7 @@ void Game::onInput() {
       iter.reset(*light);
       iter.dirtyLight();
       iter.chunk->markSavePending();
+      mWorld->submitPlayerEdit(iter);
     }
   }
   
@@ -3,6 +3,7 @@
 #include <vector>
 #include "Game/Gameplay/FollowCamera.hpp"
 #include "Game/World/World.hpp"
+#include "Game/Utils/Benchmark.hpp"
 
 class World;
 class VoxelRenderer;
@@ -47,4 +48,5 @@ protected:
   // for debug
   bool mEnableRaycast = true;
   bool mPossessPlayer = false;
+  ChunkBenchmark mChunkBenchmark;
 };
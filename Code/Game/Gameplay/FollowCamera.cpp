@@ -106,8 +106,10 @@ void FollowCamera1Person::onUpdate(float dt) {
      = clamp(mCamera->transform().localRotation().y,
                   -85.f, 85.f);
 
+#if !CUBIC_CHUNKS
     mCamera->transform().localPosition().z
      = clamp<float>(mCamera->transform().localPosition().z, 0, Chunk::kSizeZ);
+#endif
   }
 
   // transform.localRotation() = mCamera->transfrom().localRotation();
@@ -151,6 +151,13 @@ void GameApplication::renderStatisticsOverlay() const {
     ImGui::Text("World Status" "(right-click to change position)");
     ImGui::TextColored({.3f, .5f, 1.f, 1.f}, "World Time: %.4f", gGameClock->total.second / 86400.f);
 
+    ImGui::Separator();
+
+    ImGui::Text("Active Chunks: %u (%.1f MB)", mGame.world()->activeChunkCount(), 
+                float(mGame.world()->activeChunkMemory()) / (1024.f * 1024.f));
+    const ChunkPool::stats_t& pool = mGame.world()->chunkPoolStats();
+    ImGui::Text("Chunk Pool: %u/%u free, hit rate %.1f%%", pool.available, pool.constructed, pool.hitRate() * 100.f);
+
     ImGui::Separator();
     
     auto rc = mGame.playerRaycastResult();
@@ -158,7 +165,7 @@ void GameApplication::renderStatisticsOverlay() const {
 
       ivec3 coord = rc.contact.block.coords();
       BlockIndex index = rc.contact.block.index();
-      ivec2 chunkCoords = rc.contact.block.chunk->coords();
+      ChunkCoords chunkCoords = rc.contact.block.chunk->coords();
       std::string seletedBlockInfo = "";
 
       ImGui::Text("Current Chunk (%s)", chunkCoords.toString().c_str());
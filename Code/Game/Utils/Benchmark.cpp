@@ -0,0 +1,567 @@
+#include "Benchmark.hpp"
+#include <chrono>
+#include <limits>
+#include <random>
+#include <thread>
+#include "Engine/Debug/Log.hpp"
+#include "Engine/Gui/ImGui.hpp"
+#include "Game/World/World.hpp"
+#include "Game/World/ChunkSnapshot.hpp"
+#include "Game/World/BlockDef.hpp"
+#include "Game/World/BlockProperties.hpp"
+#include "Game/World/PaddedChunk.hpp"
+#include "Game/World/PendingEdits.hpp"
+#include "Game/World/MesherPool.hpp"
+#include "Game/World/WorldGenerator.hpp"
+#include "Game/World/ClimateMap.hpp"
+#include "Game/World/ChunkVertex.hpp"
+#include "Game/Utils/Config.hpp"
+#include "Game/Utils/PerlinGrid.hpp"
+#include "Engine/Math/Noise/SmoothNoise.hpp"
+
+// far away from anything saved, so chunks are always generated. nothing marks them for a save, generation
+// edits don't and the benchmark makes no player edits
+#if CUBIC_CHUNKS
+// the slab the terrain surface runs through
+static const ChunkCoords kBenchmarkCenter = ivec3{ 100000, 100000, 96 / int(Chunk::kSizeZ) };
+#else
+static const ChunkCoords kBenchmarkCenter = { 100000, 100000 };
+#endif
+static constexpr uint kBenchmarkIterations = 20;
+
+#if BLOCK_INDEX_MODE == BLOCK_INDEX_MORTON
+static constexpr const char* kIndexLayout = "morton";
+#else
+static constexpr const char* kIndexLayout = "linear";
+#endif
+
+template<typename Setup, typename Work>
+static ChunkBenchmark::result_t measure(const char* name, Setup&& setup, Work&& work) {
+  using clock = std::chrono::high_resolution_clock;
+
+  ChunkBenchmark::result_t result;
+  result.name = name;
+  result.iterations = kBenchmarkIterations;
+  result.minMs = std::numeric_limits<double>::max();
+
+  double totalMs = 0;
+  for(uint i = 0; i < kBenchmarkIterations; i++) {
+    setup();
+    auto start = clock::now();
+    work();
+    double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    totalMs += ms;
+    result.minMs = std::min(result.minMs, ms);
+  }
+
+  result.avgMs = totalMs / double(kBenchmarkIterations);
+  return result;
+}
+
+// trees of the patch reach one chunk past it. what they parked in the global store, on activation and on every
+// `Chunk::deserialize` run, is taken back before and after a run, or the next activation of the patch applies
+// the leftovers on top of fresh terrain
+static void discardPendingEdits(span<const ChunkCoords> patch) {
+  PendingEdits& store = PendingEdits::get();
+  for(const ChunkCoords& coords: patch) {
+#if CUBIC_CHUNKS
+    for(int k = -1; k <= 1; k++) {
+#else
+    {
+#endif
+      for(int j = -1; j <= 1; j++) {
+        for(int i = -1; i <= 1; i++) {
+#if CUBIC_CHUNKS
+          store.take(coords + ChunkCoords{ ivec3{ i, j, k } });
+#else
+          store.take(coords + ChunkCoords{ i, j });
+#endif
+        }
+      }
+    }
+  }
+}
+
+void ChunkBenchmark::run() {
+  mResults.clear();
+
+  // the center chunk needs all its neighbors for meshing
+  World world;
+  std::vector<ChunkCoords> patch;
+#if CUBIC_CHUNKS
+  int verticalRange = 1;
+#else
+  int verticalRange = 0;
+#endif
+  for(int k = -verticalRange; k <= verticalRange; k++) {
+    for(int j = -1; j <= 1; j++) {
+      for(int i = -1; i <= 1; i++) {
+#if CUBIC_CHUNKS
+        patch.push_back(kBenchmarkCenter + ChunkCoords{ivec3{i, j, k}});
+#else
+        patch.push_back(kBenchmarkCenter + ChunkCoords{i, j});
+#endif
+      }
+    }
+  }
+  discardPendingEdits({ patch.data(), patch.size() });
+  for(const ChunkCoords& coords: patch) {
+    world.activateChunk(coords);
+  }
+
+  Chunk& chunk = *world.findChunk(kBenchmarkCenter);
+  std::vector<byte_t> buffer(chunk.maxSerializedSize());
+
+  S<const ChunkSnapshot> snapshot;
+  mResults.push_back(measure("Chunk::constructCPUMesh", [&] { snapshot = ChunkSnapshot::capture(chunk); }, [&] {
+    // the meshers go back to the pool as the gpu mesh step would, the next run reuses their capacity
+    Chunk::section_meshers_t meshers;
+    chunk.constructCPUMesh(*snapshot, Chunk::kAllSections, meshers);
+    Chunk::releaseMeshers(meshers);
+  }));
+
+  // what a block edit costs, the section at the surface is the busiest one
+  uint surfaceSection = std::min(uint(chunk.height(0, 0)) / Chunk::kSectionSizeZ, Chunk::kSectionCount - 1);
+  mResults.push_back(measure("remesh, one section", [&] { snapshot = ChunkSnapshot::capture(chunk); }, [&] {
+    Chunk::section_meshers_t meshers;
+    chunk.constructCPUMesh(*snapshot, 1u << surfaceSection, meshers);
+    Chunk::releaseMeshers(meshers);
+  }));
+
+  // both meshers regardless of CHUNK_MESHER_MODE, the greedy mesh only draws right with the shader built for it
+  std::vector<chunk_quad_t> faceQuads, greedyQuads;
+  using collect_t = void (Chunk::*)(const ChunkSnapshot&, const PaddedChunk&, uint, std::vector<chunk_quad_t>&);
+  PaddedChunk blocks;
+  Mesher mesher;
+  vec3 pivot = chunk.coords().pivotPosition();
+  auto meshWith = [&](collect_t collect, std::vector<chunk_quad_t>& quads) {
+    quads.clear();
+    blocks.gather(*snapshot);
+    for(uint s = 0; s < Chunk::kSectionCount; s++) {
+      if(!snapshot->sectionHidden(s)) (chunk.*collect)(*snapshot, blocks, s, quads);
+    }
+    mesher.clear();
+    mesher.begin(DRAW_TRIANGES);
+    for(const chunk_quad_t& quad: quads) {
+      Chunk::addQuad(mesher, pivot, quad);
+    }
+    mesher.end();
+  };
+  mResults.push_back(measure("mesh, per face", [] {}, [&] {
+    meshWith(&Chunk::collectFaceQuads, faceQuads);
+  }));
+  mResults.push_back(measure("mesh, greedy", [] {}, [&] {
+    meshWith(&Chunk::collectGreedyQuads, greedyQuads);
+  }));
+
+  std::vector<chunk_vertex_t> packed;
+  mResults.push_back(measure("mesh, packed vertices", [] {}, [&] {
+    packed.resize(faceQuads.size() * 4);
+    for(size_t i = 0; i < faceQuads.size(); i++) {
+      chunk_vertex_t::pack(faceQuads[i], &packed[i * 4]);
+    }
+  }));
+
+  // every corner of both meshes has to come back out of the packed vertex as it went in
+  uint roundTrips = 0, mismatches = 0;
+  for(const std::vector<chunk_quad_t>* quads: { &faceQuads, &greedyQuads }) {
+    for(const chunk_quad_t& quad: *quads) {
+      chunk_vertex_t vertices[4];
+      chunk_vertex_t::pack(quad, vertices);
+      for(uint c = 0; c < 4; c++) {
+        const chunk_vertex_t& v = vertices[c];
+        bool same = v.unpackPosition() == quad.corner(c) && v.face() == quad.face 
+                 && v.sprite() == quad.sprite && v.light() == quad.light;
+        roundTrips++;
+        mismatches += same ? 0 : 1;
+      }
+    }
+  }
+
+  // `generateBlocks` without the global store, every run would park another copy of the crowns for the neighbors there
+  auto regenerate = [&] {
+    PendingEdits overflow;
+    chunk.generateTerrain(Config::kWorldSeed, overflow);
+    chunk.endBulkWrite();
+  };
+
+  // drain what the previous run left dirty first, or the next one finds it all marked already
+  mResults.push_back(measure("Chunk::initLights", [&] { world.propagateLight(false); regenerate(); }, [&] {
+    chunk.initLights();
+  }));
+
+  // flood fill through updateBlockLight, the most neighborhood heavy access pattern
+  mResults.push_back(measure("World::propagateLight", [&] {
+    world.propagateLight(false);
+    regenerate();
+    chunk.initLights();
+  }, [&] {
+    world.propagateLight(false);
+  }));
+
+  mResults.push_back(measure("Chunk::serialize", [] {}, [&] {
+    chunk.serialize(buffer.data(), buffer.size());
+  }));
+
+  // both go through the section bulk writes, lighting is gone after these
+  mResults.push_back(measure("Chunk::generateBlocks", [] {}, [&] {
+    regenerate();
+  }));
+  size_t savedSize = chunk.serialize(buffer.data(), buffer.size());
+  mResults.push_back(measure("Chunk::deserialize", [] {}, [&] {
+    chunk.deserialize(buffer.data(), savedSize);
+  }));
+
+  // the per block property read initLights and lighting do, full definition against the packed table.
+  // ids are gathered up front so the storage decode is not part of it
+  std::vector<block_id_t> ids(Chunk::kTotalBlockCount);
+  volatile uint sink = 0;
+  mResults.push_back(measure("emissive lookup, BlockDef", [&] {
+    for(uint i = 0; i < Chunk::kTotalBlockCount; i++) ids[i] = chunk.mBlocks.id(i);
+  }, [&] {
+    uint total = 0;
+    for(block_id_t id: ids) total += BlockDef::get(id)->emissive() + BlockDef::get(id)->opaque();
+    sink = total;
+  }));
+  mResults.push_back(measure("emissive lookup, BlockProperties", [] {}, [&] {
+    uint total = 0;
+    for(block_id_t id: ids) total += BlockProperties::emissive(id) + BlockProperties::opaque(id);
+    sink = total;
+  }));
+
+  // the 6 neighbor read every chunk-local kernel does, through iterators against the padded copy
+  PaddedChunk padded;
+  mResults.push_back(measure("PaddedChunk::gather", [&] { snapshot = ChunkSnapshot::capture(chunk); }, [&] {
+    padded.gather(*snapshot);
+  }));
+  mResults.push_back(measure("neighbor light, BlockIter", [] {}, [&] {
+    uint total = 0;
+    for(uint i = 0; i < Chunk::kTotalBlockCount; i++) {
+      Chunk::BlockIter iter = chunk.blockIter(BlockIndex(i));
+      Chunk::BlockIter neighbors[6] = {
+        iter.nextPosX(), iter.nextNegX(), iter.nextNegY(), iter.nextPosY(), iter.nextNegZ(), iter.nextPosZ()
+      };
+      for(Chunk::BlockIter& neighbor: neighbors) total += neighbor->light();
+    }
+    sink = total;
+  }));
+  mResults.push_back(measure("neighbor light, PaddedChunk", [] {}, [&] {
+    uint total = 0;
+    for(int z = 0; z < int(Chunk::kSizeZ); z++) {
+      for(int y = 0; y < int(Chunk::kSizeY); y++) {
+        int index = PaddedChunk::index(0, y, z);
+        for(int x = 0; x < int(Chunk::kSizeX); x++, index++) {
+          for(int offset: PaddedChunk::kFaceOffsets) total += padded[index + offset].light();
+        }
+      }
+    }
+    sink = total;
+  }));
+
+  // the surface heights of one chunk, a column at a time against the batched grid
+  std::vector<float> surface(Chunk::kSizeX * Chunk::kSizeY);
+  vec2 surfaceBase = chunk.coords().pivotPosition().xy();
+  mResults.push_back(measure("surface noise, per column", [] {}, [&] {
+    for(uint j = 0; j < Chunk::kSizeY; j++) {
+      for(uint i = 0; i < Chunk::kSizeX; i++) {
+        surface[i + j * Chunk::kSizeX] = Compute2dPerlinNoise(surfaceBase.x + float(i), surfaceBase.y + float(j), 200, 3);
+      }
+    }
+  }));
+  mResults.push_back(measure("surface noise, batched grid", [] {}, [&] {
+    Compute2dPerlinNoiseGrid(surface.data(), Chunk::kSizeX, Chunk::kSizeY, surfaceBase, 200, 3);
+  }));
+
+  // temperature and humidity of one chunk, full resolution noise against the cached coarse regions
+  std::vector<float> temperature(Chunk::kSizeX * Chunk::kSizeY), humidity(Chunk::kSizeX * Chunk::kSizeY);
+  mResults.push_back(measure("climate, per column noise", [] {}, [&] {
+    for(uint j = 0; j < Chunk::kSizeY; j++) {
+      for(uint i = 0; i < Chunk::kSizeX; i++) {
+        float x = surfaceBase.x + float(i), y = surfaceBase.y + float(j);
+        temperature[i + j * Chunk::kSizeX] = Compute2dPerlinNoise(x, y, 800, 2);
+        humidity[i + j * Chunk::kSizeX] = Compute2dPerlinNoise(x, y, 600, 2);
+      }
+    }
+  }));
+  mResults.push_back(measure("climate, ClimateMap", [] {}, [&] {
+    ClimateMap::get().sampleColumns(surfaceBase, Config::kWorldSeed, temperature.data(), humidity.data());
+  }));
+
+  // random access across the loaded patch, the map lookup against the slot table and last used chunk
+  std::vector<ivec3> positions(Chunk::kTotalBlockCount);
+  std::vector<Block> gathered(positions.size());
+  {
+    std::mt19937 rng(7);
+    ivec3 mins = ivec3(patch.front().pivotPosition());
+    std::uniform_int_distribution<int> spanX(0, 3 * int(Chunk::kSizeX) - 1);
+    std::uniform_int_distribution<int> spanY(0, 3 * int(Chunk::kSizeY) - 1);
+    std::uniform_int_distribution<int> spanZ(0, int(Chunk::kSizeZ) - 1);
+    for(ivec3& p: positions) p = mins + ivec3{ spanX(rng), spanY(rng), spanZ(rng) };
+  }
+  mResults.push_back(measure("random access, findChunk", [] {}, [&] {
+    uint total = 0;
+    for(const ivec3& p: positions) {
+      vec3 position = vec3(p) + vec3{ .5f, .5f, .5f };
+      Chunk* c = world.findChunk(position);
+      total += c->blockIter(position)->light();
+    }
+    sink = total;
+  }));
+  mResults.push_back(measure("random access, World::blocks", [] {}, [&] {
+    world.blocks({ positions.data(), positions.size() }, { gathered.data(), gathered.size() });
+  }));
+
+  (void)sink;
+  Log::logf("block property table: %u bytes, BlockDef: %u bytes each", 
+            (uint)BlockProperties::memoryUsage(), (uint)sizeof(BlockDef));
+
+  Log::logf("chunk benchmark, block storage: %s, index: %s, chunk memory: %u bytes, uniform sections: %u/%u", 
+            Chunk::Storage::kName, kIndexLayout, (uint)chunk.memoryUsage(), 
+            chunk.mBlocks.uniformSectionCount(), Chunk::kSectionCount);
+  Log::logf("mesher pool: %u pooled of %u", (uint)MesherPool::get().pooledCount(), (uint)MesherPool::kMaxPooled);
+  Log::logf("climate map: %u cached regions of %u", 
+            (uint)ClimateMap::get().cachedRegionCount(), ClimateMap::kMaxCachedRegions);
+
+  // 4 vertices and 6 indices per quad
+  auto meshBytes = [](size_t quads, size_t vertexSize) { return uint(quads * (4 * vertexSize + 6 * sizeof(uint32_t))); };
+  for(const std::vector<chunk_quad_t>* quads: { &faceQuads, &greedyQuads }) {
+    Log::logf("chunk mesh, %s: %u quads, %u vertices, %u bytes lit, %u bytes packed", 
+              quads == &faceQuads ? "per face" : "greedy", (uint)quads->size(), (uint)quads->size() * 4, 
+              meshBytes(quads->size(), sizeof(vertex_lit_t)), meshBytes(quads->size(), sizeof(chunk_vertex_t)));
+  }
+  Log::logf("chunk vertex: lit %u bytes, packed %u bytes, round trip %u vertices, %u mismatches", 
+            (uint)sizeof(vertex_lit_t), (uint)sizeof(chunk_vertex_t), roundTrips, mismatches);
+
+  for(const ChunkCoords& coords: patch) {
+    world.deactivateChunk(coords);
+  }
+  discardPendingEdits({ patch.data(), patch.size() });
+
+  for(const result_t& result: mResults) {
+    Log::logf("  %-32s avg %8.3f ms, min %8.3f ms", result.name.c_str(), result.avgMs, result.minMs);
+  }
+}
+
+// blocks streamed by `runLayouts`, the size of the gpu world volume
+static constexpr uint kStreamExtentXY = VOLUME_SIZE_XY;
+static constexpr uint kStreamExtentZ = 256;
+
+// the plain heightmap terrain (stone | dust | grass, no biomes, trees or density) written straight into
+// `Layout::Storage`, then one pass over the ids the way `Chunk::serialize` does it. only the layouts are
+// compared, so it doesn't follow `Chunk::generateBlocks`
+template<typename Layout>
+static ChunkBenchmark::layout_result_t measureLayout(const char* name) {
+  using Storage = typename Layout::Storage;
+  using clock = std::chrono::high_resolution_clock;
+
+  static_assert(kStreamExtentZ % Layout::kSizeZ == 0, "chunks have to stack up to the streamed height");
+  constexpr uint kCountX = kStreamExtentXY / Layout::kSizeX;
+  constexpr uint kCountY = kStreamExtentXY / Layout::kSizeY;
+  constexpr uint kCountZ = kStreamExtentZ / Layout::kSizeZ;
+
+  constexpr float kWorldSeaLevel = 100;
+  constexpr float kChangeRange = (float(kStreamExtentZ) - kWorldSeaLevel) / 3.f;
+
+  const BlockDef* air = BlockDef::get("air");
+  const BlockDef* dust = BlockDef::get("dust");
+  const BlockDef* stone = BlockDef::get("stone");
+  const BlockDef* grass = BlockDef::get("grass");
+  auto flagsOf = [](const BlockDef* def) { return uint8_t(def->opaque() ? Block::kOpaqueFlag : 0x0); };
+
+  std::vector<std::unique_ptr<Storage>> chunks;
+  chunks.reserve(kCountX * kCountY * kCountZ);
+  std::vector<float> heights(Layout::kSizeX * Layout::kSizeY);
+  uint runCount = 0;
+
+  auto start = clock::now();
+  for(uint cy = 0; cy < kCountY; cy++) {
+    for(uint cx = 0; cx < kCountX; cx++) {
+      vec2 base = { float(kBenchmarkCenter.x * int(Chunk::kSizeX) + int(cx * Layout::kSizeX)), 
+                    float(kBenchmarkCenter.y * int(Chunk::kSizeY) + int(cy * Layout::kSizeY)) };
+      float minZMax = float(kStreamExtentZ), maxZMax = 0;
+      Compute2dPerlinNoiseGrid(heights.data(), Layout::kSizeX, Layout::kSizeY, base, 200, 3);
+      for(uint j = 0; j < Layout::kSizeY; j++) {
+        for(uint i = 0; i < Layout::kSizeX; i++) {
+          float h = kChangeRange * heights[i + j * Layout::kSizeX] + kWorldSeaLevel;
+          heights[i + j * Layout::kSizeX] = h;
+          minZMax = std::min(minZMax, h);
+          maxZMax = std::max(maxZMax, h);
+        }
+      }
+
+      for(uint cz = 0; cz < kCountZ; cz++) {
+        Storage& storage = *chunks.emplace_back(new Storage());
+        for(uint s = 0; s < Layout::kSectionCount; s++) {
+          int sectionBottom = int(cz * Layout::kSizeZ + s * Layout::kSectionSizeZ);
+          int sectionTop = sectionBottom + int(Layout::kSectionSizeZ) - 1;
+          if(float(sectionBottom) > maxZMax) {
+            storage.fill(s, air->id(), flagsOf(air));
+            continue;
+          }
+          if(float(sectionTop) < minZMax - 3) {
+            storage.fill(s, stone->id(), flagsOf(stone));
+            continue;
+          }
+
+          uint index = s * Layout::kSectionBlockCount;
+          for(int k = sectionBottom; k <= sectionTop; k++) {
+            for(uint j = 0; j < Layout::kSizeY; j++) {
+              for(uint i = 0; i < Layout::kSizeX; i++, index++) {
+                float zMax = heights[i + j * Layout::kSizeX];
+                const BlockDef* def = float(k) > zMax ? air : float(k) >= zMax - 1 ? grass : float(k) >= zMax - 3 ? dust : stone;
+                storage.reset(index, def->id(), flagsOf(def));
+              }
+            }
+          }
+          storage.compact(s);
+        }
+
+        // save pass, a uniform section is a single run
+        block_id_t last = block_id_t(~0);
+        for(uint s = 0; s < Layout::kSectionCount; s++) {
+          if(storage.uniform(s)) {
+            runCount += storage.uniformBlock(s).id() != last;
+            last = storage.uniformBlock(s).id();
+            continue;
+          }
+          for(uint i = s * Layout::kSectionBlockCount; i < (s + 1) * Layout::kSectionBlockCount; i++) {
+            block_id_t id = storage.id(i);
+            runCount += id != last;
+            last = id;
+          }
+        }
+      }
+    }
+  }
+
+  ChunkBenchmark::layout_result_t result;
+  result.name = name;
+  result.chunkCount = uint(chunks.size());
+  result.streamMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+  // the chunk object minus what scales with the dimensions, plus a node and a bucket in the hash map
+  constexpr size_t kChunkFixed = sizeof(Chunk) - sizeof(Chunk::Storage) - Chunk::Layout::kMaskMemory;
+  constexpr size_t kMapEntry = sizeof(std::pair<const ChunkCoords, Chunk*>) + 3 * sizeof(void*);
+  for(const std::unique_ptr<Storage>& storage: chunks) {
+    result.blockMemory += storage->memoryUsage();
+  }
+  result.overheadMemory = chunks.size() * (kChunkFixed + Layout::kMaskMemory + kMapEntry);
+
+  Log::logf("  %-12s %5u chunks, %8.3f ms, blocks %7.2f MB, overhead %6.2f MB, %u runs", 
+            name, result.chunkCount, result.streamMs, 
+            double(result.blockMemory) / (1024.0 * 1024.0), double(result.overheadMemory) / (1024.0 * 1024.0), runCount);
+  return result;
+}
+
+void ChunkBenchmark::runLayouts() {
+  mLayoutResults.clear();
+
+  Log::logf("chunk layout benchmark, %ux%ux%u blocks, block storage: %s", 
+            kStreamExtentXY, kStreamExtentXY, kStreamExtentZ, Chunk::Storage::kName);
+  mLayoutResults.push_back(measureLayout<ChunkLayout<4, 4, 8>>("16x16x256"));
+  mLayoutResults.push_back(measureLayout<ChunkLayout<5, 5, 8>>("32x32x256"));
+  mLayoutResults.push_back(measureLayout<ChunkLayout<5, 5, 5>>("32x32x32"));
+}
+
+// chunks of the generation batch, a square of columns (a few slabs of them with cubic chunks)
+static constexpr int kGenerationExtentXY = 8;
+#if CUBIC_CHUNKS
+static constexpr int kGenerationExtentZ = 4;
+#endif
+
+static uint64_t hashBlocks(const Chunk::Storage& blocks) {
+  uint64_t hash = 14695981039346656037ull;
+  for(uint i = 0; i < Chunk::kTotalBlockCount; i++) {
+    hash = (hash ^ blocks.id(i)) * 1099511628211ull;
+  }
+  return hash;
+}
+
+void ChunkBenchmark::runGeneration() {
+  using clock = std::chrono::high_resolution_clock;
+  mGenerationResults.clear();
+
+  ChunkCoords mins = kBenchmarkCenter;
+#if CUBIC_CHUNKS
+  ChunkCoords maxs = kBenchmarkCenter + ChunkCoords{ ivec3{ kGenerationExtentXY - 1, kGenerationExtentXY - 1, kGenerationExtentZ - 1 } };
+  mins.z -= kGenerationExtentZ / 2;
+  maxs.z -= kGenerationExtentZ / 2;
+#else
+  ChunkCoords maxs = kBenchmarkCenter + ChunkCoords{ kGenerationExtentXY - 1, kGenerationExtentXY - 1 };
+#endif
+
+  WorldGenerator generator(Config::kWorldSeed);
+  std::vector<ChunkCoords> coords = WorldGenerator::range(mins, maxs);
+  std::vector<std::unique_ptr<Chunk>> owned;
+  std::vector<Chunk*> chunks;
+  for(const ChunkCoords& c: coords) {
+    chunks.push_back(owned.emplace_back(new Chunk(c)).get());
+  }
+
+  // 1, 2, 4 .. jobs up to the hardware threads, a job is on one core at a time
+  std::vector<uint> jobCounts;
+  uint threadCount = std::max(1u, std::thread::hardware_concurrency());
+  for(uint jobCount = 1; jobCount < threadCount; jobCount *= 2) jobCounts.push_back(jobCount);
+  jobCounts.push_back(threadCount);
+
+  // the same chunks are generated over again. every section is rewritten and the batch keeps its tree edits
+  // in a store of its own, so no run sees what an earlier one left
+  std::vector<uint64_t> reference;
+  for(uint jobCount: jobCounts) {
+    auto start = clock::now();
+    generator.generate({ chunks.data(), chunks.size() }, jobCount);
+    double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    generation_result_t result;
+    result.jobCount = jobCount;
+    result.chunkCount = uint(chunks.size());
+    result.ms = ms;
+    result.chunksPerSecond = double(chunks.size()) * 1000.0 / ms;
+
+    for(size_t i = 0; i < chunks.size(); i++) {
+      uint64_t hash = hashBlocks(chunks[i]->mBlocks);
+      if(reference.size() < chunks.size()) {
+        reference.push_back(hash);
+      } else {
+        result.deterministic = result.deterministic && reference[i] == hash;
+      }
+    }
+    mGenerationResults.push_back(result);
+  }
+
+  Log::logf("chunk generation benchmark, seed %u, %u chunks, %u hardware threads", 
+            generator.seed(), (uint)chunks.size(), threadCount);
+  for(const generation_result_t& result: mGenerationResults) {
+    Log::logf("  %2u jobs: %8.3f ms, %8.1f chunks/s%s", result.jobCount, result.ms, result.chunksPerSecond,
+              result.deterministic ? "" : ", BLOCKS DIFFER FROM 1 JOB");
+  }
+}
+
+void ChunkBenchmark::onGui() {
+  ImGui::Begin("Chunk Benchmark");
+  ImGui::Text("Block storage: %s, index: %s", Chunk::Storage::kName, kIndexLayout);
+  if(ImGui::Button("Run")) {
+    run();
+  }
+  ImGui::SameLine();
+  if(ImGui::Button("Run layouts")) {
+    runLayouts();
+  }
+  ImGui::SameLine();
+  if(ImGui::Button("Run generation")) {
+    runGeneration();
+  }
+  for(const result_t& result: mResults) {
+    ImGui::Text("%-32s avg %8.3f ms, min %8.3f ms", result.name.c_str(), result.avgMs, result.minMs);
+  }
+  for(const layout_result_t& result: mLayoutResults) {
+    ImGui::Text("%-12s %5u chunks, %8.3f ms, blocks %7.2f MB, overhead %6.2f MB", 
+                result.name.c_str(), result.chunkCount, result.streamMs, 
+                double(result.blockMemory) / (1024.0 * 1024.0), double(result.overheadMemory) / (1024.0 * 1024.0));
+  }
+  for(const generation_result_t& result: mGenerationResults) {
+    ImGui::Text("%2u jobs: %8.3f ms, %8.1f chunks/s%s", result.jobCount, result.ms, result.chunksPerSecond,
+                result.deterministic ? "" : ", blocks differ from 1 job");
+  }
+  ImGui::End();
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "Engine/Core/common.hpp"
+#include "Game/World/Chunk.hpp"
+
+// times the chunk pipeline stages on a small patch of freshly generated chunks.
+// build configurations (block storage layout etc.) are compile time, so run it once per build to compare.
+class ChunkBenchmark {
+public:
+  struct result_t {
+    std::string name;
+    uint iterations = 0;
+    double avgMs = 0;
+    double minMs = 0;
+  };
+
+  // streaming the same area with other chunk dimensions, on the block storage alone
+  struct layout_result_t {
+    std::string name;
+    uint chunkCount = 0;
+    double streamMs = 0;
+    size_t blockMemory = 0;
+    // per chunk bookkeeping (chunk object, masks, `World::mActiveChunks` entry) times the chunk count
+    size_t overheadMemory = 0;
+  };
+
+  // one batch through `WorldGenerator` with a given number of jobs
+  struct generation_result_t {
+    uint jobCount = 0;
+    uint chunkCount = 0;
+    double ms = 0;
+    double chunksPerSecond = 0;
+    // same blocks as the single job batch
+    bool deterministic = true;
+  };
+
+  void run();
+  void runLayouts();
+  void runGeneration();
+  void onGui();
+
+  const std::vector<result_t>& results() const { return mResults; }
+  const std::vector<layout_result_t>& layoutResults() const { return mLayoutResults; }
+  const std::vector<generation_result_t>& generationResults() const { return mGenerationResults; }
+
+protected:
+  std::vector<result_t> mResults;
+  std::vector<layout_result_t> mLayoutResults;
+  std::vector<generation_result_t> mGenerationResults;
+};
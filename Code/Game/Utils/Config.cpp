@@ -2,8 +2,11 @@
 
 float Config::kMaxActivateDistance = 200;
 float Config::kMinDeactivateDistance = 250;
+float Config::kMaxVerticalActivateDistance = 64;
+float Config::kMinVerticalDeactivateDistance = 96;
 uint Config::kMaxChunkActivatePerFrame = 100;
 uint Config::kMaxChunkDeactivatePerFrame = 1;
 uint Config::kMaxChunkReconstructMeshPerFrame = 20;
 float Config::kWorldTimeScale = 200;
-float Config::kGravity = 20;
\ No newline at end of file
+float Config::kGravity = 20;
+uint Config::kWorldSeed = 0;
\ No newline at end of file
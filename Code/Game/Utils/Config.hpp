@@ -4,9 +4,14 @@
 struct Config {
   static float kMaxActivateDistance;
   static float kMinDeactivateDistance;
+  // cubic chunks only, how far up and down the slabs are streamed
+  static float kMaxVerticalActivateDistance;
+  static float kMinVerticalDeactivateDistance;
   static uint kMaxChunkActivatePerFrame;
   static uint kMaxChunkDeactivatePerFrame;
   static uint kMaxChunkReconstructMeshPerFrame;
   static float kWorldTimeScale;
   static float kGravity;
+  // every generated chunk only depends on it and its coords
+  static uint kWorldSeed;
 };
\ No newline at end of file
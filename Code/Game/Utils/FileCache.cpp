@@ -16,9 +16,16 @@ void FileCache::init() {
   });
 }
 
+static std::string chunkSavePath(const ChunkCoords& coords) {
+#if CUBIC_CHUNKS
+  return Stringf(FileCache::kChunkSaveLocationFormatStr, coords.x, coords.y, coords.z);
+#else
+  return Stringf(FileCache::kChunkSaveLocationFormatStr, coords.x, coords.y);
+#endif
+}
+
 bool FileCache::load(Chunk& chunk) const {
-  ChunkCoords coords = chunk.coords();
-  std::string path = Stringf(kChunkSaveLocationFormatStr, coords.x, coords.y);
+  std::string path = chunkSavePath(chunk.coords());
 
   if(!exists(path)) return false;
 
@@ -27,24 +34,22 @@ bool FileCache::load(Chunk& chunk) const {
   EXPECTS(physicalPaths.size() == 1);
   
   Blob data = fs::read(physicalPaths[0]);
-  chunk.deserialize(data, data.size());
-
-  return true;
+  return chunk.deserialize(data, data.size());
 }
 
 bool FileCache::save(Chunk& chunk) const {
-  ChunkCoords coords = chunk.coords();
-  std::string path = Stringf(kChunkSaveLocationFormatStr, coords.x, coords.y);
+  std::string path = chunkSavePath(chunk.coords());
 
   auto physicalPaths = FileSystem::Get().map(path);
   // should only map to one dir
   EXPECTS(physicalPaths.size() == 1);
 
-  size_t bufSize = Chunk::kTotalBlockCount * 2 + 16; // worst case
-  byte_t* buf = (byte_t*)_alloca(bufSize); 
-  size_t total = chunk.serialize(buf, bufSize);
+  // worst case, too big for the stack with larger chunk dimensions
+  thread_local std::vector<byte_t> buf;
+  buf.resize(chunk.maxSerializedSize());
+  size_t total = chunk.serialize(buf.data(), buf.size());
 
-  fs::write(physicalPaths[0], buf, total);
+  fs::write(physicalPaths[0], buf.data(), total);
 
   return true;
 }
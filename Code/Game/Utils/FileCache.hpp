@@ -3,12 +3,17 @@
 #include <unordered_set>
 #include "Engine/File/Path.hpp"
 #include "Engine/Async/Job.hpp"
+#include "Game/World/ChunkDims.hlsli"
 
 class Chunk;
 
 class FileCache {
 public:
+#if CUBIC_CHUNKS
+  static constexpr const char* kChunkSaveLocationFormatStr = "/Saves/Chunk_%i,%i,%i.chunk";
+#else
   static constexpr const char* kChunkSaveLocationFormatStr = "/Saves/Chunk_%i,%i.chunk";
+#endif
   static constexpr const char* kChunkSaveLocationDir = "/Saves";
   static FileCache& get();
   void init();
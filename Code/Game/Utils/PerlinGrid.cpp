@@ -0,0 +1,222 @@
+#include "PerlinGrid.hpp"
+#include <emmintrin.h>
+#include "Engine/Math/Primitives/vec2.hpp"
+#include "Engine/Math/Noise/SmoothNoise.hpp"
+#include "Engine/Debug/Log.hpp"
+
+// the constants of the scalar path, see SmoothNoise.cpp
+static constexpr float kOctaveOffset = 0.636764989593174f;
+static constexpr float kPerlinRange = 0.662578106f;
+static const float kGradients[8][2] = {
+  { +0.923879533f, +0.382683432f },
+  { +0.382683432f, +0.923879533f },
+  { -0.382683432f, +0.923879533f },
+  { -0.923879533f, +0.382683432f },
+  { -0.923879533f, -0.382683432f },
+  { -0.382683432f, -0.923879533f },
+  { +0.382683432f, -0.923879533f },
+  { +0.923879533f, -0.382683432f },
+};
+
+// squirrel noise, same as `Get2dNoiseUint`
+static uint latticeHash(int x, int y, uint seed) {
+  constexpr uint kBitNoise1 = 0x68E31DA4;
+  constexpr uint kBitNoise2 = 0xB5297A4D;
+  constexpr uint kBitNoise3 = 0x1B56C4E9;
+  constexpr uint kPrime = 198491317;
+
+  uint mangled = uint(x) + kPrime * uint(y);
+  mangled *= kBitNoise1;
+  mangled += seed;
+  mangled ^= (mangled >> 8);
+  mangled += kBitNoise2;
+  mangled ^= (mangled << 8);
+  mangled *= kBitNoise3;
+  mangled ^= (mangled >> 8);
+  return mangled;
+}
+
+// `FastFloor`, whole negative numbers land one cell lower, kept that way
+static int fastFloor(float f) {
+  return f >= 0.f ? int(f) : int(f) - 1;
+}
+
+static __m128 fastFloor4(__m128 f) {
+  __m128i truncated = _mm_cvttps_epi32(f);
+  // the compare is all ones (-1) where negative
+  __m128i negative = _mm_castps_si128(_mm_cmplt_ps(f, _mm_setzero_ps()));
+  return _mm_cvtepi32_ps(_mm_add_epi32(truncated, negative));
+}
+
+static __m128 smoothStep4(__m128 t) {
+  // t * t * (3 - 2t)
+  __m128 twoT = _mm_mul_ps(_mm_set1_ps(2.f), t);
+  return _mm_mul_ps(_mm_mul_ps(t, t), _mm_sub_ps(_mm_set1_ps(3.f), twoT));
+}
+
+static __m128 dot4(__m128 gx, __m128 gy, __m128 dx, __m128 dy) {
+  return _mm_add_ps(_mm_mul_ps(gx, dx), _mm_mul_ps(gy, dy));
+}
+
+struct lattice_t {
+  int minX = 0, minY = 0;
+  int countX = 0, countY = 0;
+  std::vector<uint8_t> gradients;
+
+  void build(int x0, int y0, int x1, int y1, uint seed) {
+    minX = x0; minY = y0;
+    countX = x1 - x0 + 1; countY = y1 - y0 + 1;
+    gradients.resize(size_t(countX) * size_t(countY));
+    for(int y = 0; y < countY; y++) {
+      for(int x = 0; x < countX; x++) {
+        gradients[x + y * countX] = uint8_t(latticeHash(minX + x, minY + y, seed) & 0x7);
+      }
+    }
+  }
+
+  const float* at(int x, int y) const { return kGradients[gradients[(x - minX) + (y - minY) * countX]]; }
+};
+
+static void computeGrid(float* out, uint countX, uint countY, const vec2& origin,
+                        float scale, uint numOctaves, float octavePersistence, float octaveScale, bool renormalize, uint seed) {
+  uint total = countX * countY;
+  uint laneCount = (total + 3) & ~3u;
+
+  thread_local std::vector<float> posX, posY, noise;
+  thread_local lattice_t lattice;
+  posX.resize(laneCount); posY.resize(laneCount); noise.assign(laneCount, 0.f);
+
+  float invScale = 1.f / scale;
+  for(uint n = 0; n < laneCount; n++) {
+    // the padding lanes repeat the last point
+    uint p = std::min(n, total - 1);
+    posX[n] = (origin.x + float(p % countX)) * invScale;
+    posY[n] = (origin.y + float(p / countX)) * invScale;
+  }
+
+  float totalAmplitude = 0.f;
+  float currentAmplitude = 1.f;
+  const __m128 one = _mm_set1_ps(1.f);
+
+  for(uint octave = 0; octave < numOctaves; octave++) {
+    // corners shared by the whole grid, positions only grow with i and j
+    lattice.build(fastFloor(posX[0]), fastFloor(posY[0]), 
+                  fastFloor(posX[total - 1]) + 1, fastFloor(posY[total - 1]) + 1, seed);
+
+    __m128 amplitude = _mm_set1_ps(currentAmplitude);
+    for(uint n = 0; n < laneCount; n += 4) {
+      __m128 px = _mm_loadu_ps(&posX[n]);
+      __m128 py = _mm_loadu_ps(&posY[n]);
+      __m128 minX = fastFloor4(px);
+      __m128 minY = fastFloor4(py);
+      __m128 maxX = _mm_add_ps(minX, one);
+      __m128 maxY = _mm_add_ps(minY, one);
+
+      alignas(16) float cellX[4], cellY[4];
+      _mm_store_ps(cellX, minX);
+      _mm_store_ps(cellY, minY);
+      alignas(16) float g[8][4];
+      // mostly all four lanes sit in the same cell
+      bool sameCell = cellX[0] == cellX[1] && cellX[0] == cellX[2] && cellX[0] == cellX[3] 
+                   && cellY[0] == cellY[1] && cellY[0] == cellY[2] && cellY[0] == cellY[3];
+      for(uint lane = 0; lane < (sameCell ? 1u : 4u); lane++) {
+        int x = int(cellX[lane]), y = int(cellY[lane]);
+        const float* sw = lattice.at(x, y);
+        const float* se = lattice.at(x + 1, y);
+        const float* nw = lattice.at(x, y + 1);
+        const float* ne = lattice.at(x + 1, y + 1);
+        g[0][lane] = sw[0]; g[1][lane] = sw[1];
+        g[2][lane] = se[0]; g[3][lane] = se[1];
+        g[4][lane] = nw[0]; g[5][lane] = nw[1];
+        g[6][lane] = ne[0]; g[7][lane] = ne[1];
+      }
+      if(sameCell) {
+        for(uint k = 0; k < 8; k++) g[k][1] = g[k][2] = g[k][3] = g[k][0];
+      }
+
+      __m128 fromWestX = _mm_sub_ps(px, minX);
+      __m128 fromSouthY = _mm_sub_ps(py, minY);
+      __m128 fromEastX = _mm_sub_ps(px, maxX);
+      __m128 fromNorthY = _mm_sub_ps(py, maxY);
+
+      __m128 dotSW = dot4(_mm_load_ps(g[0]), _mm_load_ps(g[1]), fromWestX, fromSouthY);
+      __m128 dotSE = dot4(_mm_load_ps(g[2]), _mm_load_ps(g[3]), fromEastX, fromSouthY);
+      __m128 dotNW = dot4(_mm_load_ps(g[4]), _mm_load_ps(g[5]), fromWestX, fromNorthY);
+      __m128 dotNE = dot4(_mm_load_ps(g[6]), _mm_load_ps(g[7]), fromEastX, fromNorthY);
+
+      __m128 weightEast = smoothStep4(fromWestX);
+      __m128 weightNorth = smoothStep4(fromSouthY);
+      __m128 weightWest = _mm_sub_ps(one, weightEast);
+      __m128 weightSouth = _mm_sub_ps(one, weightNorth);
+
+      __m128 blendSouth = _mm_add_ps(_mm_mul_ps(weightEast, dotSE), _mm_mul_ps(weightWest, dotSW));
+      __m128 blendNorth = _mm_add_ps(_mm_mul_ps(weightEast, dotNE), _mm_mul_ps(weightWest, dotNW));
+      __m128 blendTotal = _mm_add_ps(_mm_mul_ps(weightSouth, blendSouth), _mm_mul_ps(weightNorth, blendNorth));
+      __m128 octaveNoise = _mm_mul_ps(blendTotal, _mm_set1_ps(1.f / kPerlinRange));
+
+      __m128 accumulated = _mm_add_ps(_mm_loadu_ps(&noise[n]), _mm_mul_ps(octaveNoise, amplitude));
+      _mm_storeu_ps(&noise[n], accumulated);
+
+      // on to the next octave
+      px = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(octaveScale)), _mm_set1_ps(kOctaveOffset));
+      py = _mm_add_ps(_mm_mul_ps(py, _mm_set1_ps(octaveScale)), _mm_set1_ps(kOctaveOffset));
+      _mm_storeu_ps(&posX[n], px);
+      _mm_storeu_ps(&posY[n], py);
+    }
+
+    totalAmplitude += currentAmplitude;
+    currentAmplitude *= octavePersistence;
+    seed++;
+  }
+
+  for(uint n = 0; n < laneCount; n += 4) {
+    __m128 value = _mm_loadu_ps(&noise[n]);
+    if(renormalize && totalAmplitude > 0.f) {
+      value = _mm_div_ps(value, _mm_set1_ps(totalAmplitude));
+      value = _mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(.5f)), _mm_set1_ps(.5f));
+      value = smoothStep4(value);
+      value = _mm_sub_ps(_mm_mul_ps(value, _mm_set1_ps(2.f)), one);
+    }
+    _mm_storeu_ps(&noise[n], value);
+  }
+
+  memcpy(out, noise.data(), sizeof(float) * total);
+}
+
+// a grid on each side of the origin, negative whole coords hit the `FastFloor` corner case
+static bool matchesScalarPath() {
+  static const vec2 origins[] = { { 1024.f, 2048.f }, { -4000.f, -600.f }, { -8.f, 3.5f } };
+  for(const vec2& origin: origins) {
+    float grid[16 * 16];
+    computeGrid(grid, 16, 16, origin, 200.f, 3, .5f, 2.f, true, 0);
+    for(uint j = 0; j < 16; j++) {
+      for(uint i = 0; i < 16; i++) {
+        float expected = Compute2dPerlinNoise(origin.x + float(i), origin.y + float(j), 200.f, 3);
+        if(memcmp(&expected, &grid[i + j * 16], sizeof(float)) != 0) {
+          Log::logf("batched perlin differs from Compute2dPerlinNoise at (%f, %f), staying on the scalar path", 
+                    origin.x + float(i), origin.y + float(j));
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+void Compute2dPerlinNoiseGrid(float* out, uint countX, uint countY, const vec2& origin,
+                              float scale, uint numOctaves, float octavePersistence, float octaveScale, bool renormalize, uint seed) {
+  EXPECTS(countX > 0 && countY > 0 && scale > 0.f);
+  static const bool batched = matchesScalarPath();
+
+  if(batched) {
+    computeGrid(out, countX, countY, origin, scale, numOctaves, octavePersistence, octaveScale, renormalize, seed);
+    return;
+  }
+
+  for(uint j = 0; j < countY; j++) {
+    for(uint i = 0; i < countX; i++) {
+      out[i + j * countX] = Compute2dPerlinNoise(origin.x + float(i), origin.y + float(j), scale, numOctaves, 
+                                                  octavePersistence, octaveScale, renormalize, seed);
+    }
+  }
+}
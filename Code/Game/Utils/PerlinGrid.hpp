@@ -0,0 +1,13 @@
+#pragma once
+#include "Engine/Core/common.hpp"
+
+class vec2;
+
+// `Compute2dPerlinNoise` over a countX x countY grid of points `origin + (i, j)`, written to out[i + j * countX].
+// four points per sse lane set, the lattice gradients of each octave are hashed once for the whole grid.
+// every lane repeats the scalar path operation for operation, so the result is bit identical. that is checked
+// against the engine once on first use, a mismatch logs and falls back to the scalar path for good
+void Compute2dPerlinNoiseGrid(float* out, uint countX, uint countY, const vec2& origin,
+                              float scale, uint numOctaves, 
+                              float octavePersistence = .5f, float octaveScale = 2.f, 
+                              bool renormalize = true, uint seed = 0);
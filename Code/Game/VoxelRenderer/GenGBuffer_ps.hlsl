@@ -1,11 +1,23 @@
 #include "GenGBuffer.hlsli"
+#include "../World/ChunkMeshFormat.hlsli"
 
 [RootSignature(GenBuffer_RootSig)]
 PSOutput main(PSInput input)
 {
 	PSOutput output;
 
+#if CHUNK_MESHER_MODE == CHUNK_MESHER_GREEDY
+	// uv counts blocks across the merged quad, wrap it into the sprite the color carries.
+	// gradients come from the unwrapped uv so mips do not jump at block edges
+	float2 unit = 1.f / float2(SPRITESHEET_UNIT_COUNT_X, SPRITESHEET_UNIT_COUNT_Y);
+	float2 sprite = round(input.color.zw * 255.f);
+	float2 spriteMins = float2(sprite.x, sprite.y + 1.f) * unit;
+	float2 extent = float2(unit.x, -unit.y);
+	float2 uv = spriteMins + frac(input.uv) * extent;
+	float4 texColor = gTexAlbedo.SampleGrad(gSampler, uv, ddx(input.uv) * extent, ddy(input.uv) * extent);
+#else
 	float4 texColor = gTexAlbedo.Sample(gSampler, input.uv);
+#endif
 	// float4 texColor = input.color;
   // output.color = float4(
 	// 	PhongLighting(input.worldPosition, input.normal, texColor.xyz, input.eyePosition), 1.f);
@@ -90,7 +90,7 @@ void VoxelRenderer::onLoad(RHIContext&) {
   mFrameData.gViewDistance.x = Config::kMaxActivateDistance - 100;
   mFrameData.gViewDistance.y = Config::kMaxActivateDistance;
 
-  mWorldVolume.init(16, 16, TEXTURE_FORMAT_R32_UINT);
+  mWorldVolume.init(GPUVolume::kTileCountX, GPUVolume::kTileCountY, TEXTURE_FORMAT_R32_UINT);
 
 
   defineRenderPasses();
@@ -168,10 +168,13 @@ void VoxelRenderer::onRenderGui(RHIContext&) {
 }
 
 void VoxelRenderer::issueChunk(const Chunk* chunk) {
-  if(chunk->mesh() == nullptr) return;
-
-  vec3 basePosition = chunk->coords().pivotPosition();
-  mFrameRenderData.emplace_back(ChunkRenderData{chunk->mesh(), mat44::translation(basePosition), chunk});
+  // the section meshes share the chunk's transform and meta data
+  mat44 model = mat44::translation(chunk->coords().pivotPosition());
+  for(uint s = 0; s < Chunk::kSectionCount; s++) {
+    Mesh* mesh = chunk->sectionMesh(s);
+    if(mesh == nullptr) continue;
+    mFrameRenderData.emplace_back(ChunkRenderData{mesh, model, chunk});
+  }
 }
 
 void VoxelRenderer::updatePlayerPosition(vec3 playerPosition) {
@@ -1,6 +1,7 @@
 #include "Common.hlsli"
 #include "Debug.hlsli"
 #include "VolumeUtil.hlsli"
+#include "../World/ChunkDims.hlsli"
 
 #define RT_RootSig \
     "RootFlags(ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT), " \
@@ -19,14 +20,14 @@ Texture2D<float> gTexDepth:   register(t5);
 RWTexture2D<float4> uTexAO: register(u0); 
 static uint seed;
 
-#define BD_X 16
-#define BD_Y 16
-#define BD_Z 256
+#define BD_X CHUNK_SIZE_X
+#define BD_Y CHUNK_SIZE_Y
+#define BD_Z CHUNK_SIZE_Z
 
 #define BD	BD_X, BD_Y, BD_Z
 
-static const uint2 kPlayerTileIndex = 16u.xx >> 1;
-static const uint3 kPlayerChunk00Block = uint3(16u.xx * kPlayerTileIndex, 0);
+static const uint2 kPlayerTileIndex = uint2(VOLUME_TILE_COUNT_X, VOLUME_TILE_COUNT_Y) >> 1;
+static const uint3 kPlayerChunk00Block = uint3(uint2(BD_X, BD_Y) * kPlayerTileIndex, 0);
 static uint3 kPixCoords;
 
 static float3 kVolumeAnchorPositionW;
@@ -50,9 +51,13 @@ void init() {
  uint3 blockCoords;
  toVoxelCoords(playerPosition.xyz, chunkCoords, blockCoords);
 
- float3 playerChunkAnchor = float3(chunkCoords * 16.f, 0);
+ float3 playerChunkAnchor = float3(chunkCoords * float2(BD_X, BD_Y), 0);
+#if CUBIC_CHUNKS
+ // the volume only holds the slab the viewer is in
+ playerChunkAnchor.z = floor(playerPosition.z / BD_Z) * BD_Z;
+#endif
 
- kVolumeAnchorPositionW = playerChunkAnchor - float3(16 * 8, 16 * 8, 0);
+ kVolumeAnchorPositionW = playerChunkAnchor - float3(kPlayerChunk00Block);
 }
 
 
@@ -183,7 +188,7 @@ float3 deltaT(float3 direction, uint mip) {
 }
 
 bool inRange(int3 volumeCoords, uint mip) {
-	return all(volumeCoords < int3( 256u.xxx / (1 << mip))) && all(volumeCoords >= 0);
+	return all(volumeCoords < int3(uint3(VOLUME_SIZE_XY, VOLUME_SIZE_XY, BD_Z) / (1 << mip))) && all(volumeCoords >= 0);
 }
 
 bool isOpaque(uint3 coords, uint mip) {
@@ -1,12 +1,21 @@
 ﻿#pragma once
 #include "Engine/Core/common.hpp"
 #include "Game/World/BlockDef.hpp"
+#include "Game/World/BlockProperties.hpp"
 
 class BlockDef;
+template<uint kCount> class DenseBlockStorage;
+template<uint kCount> class PaletteBlockStorage;
+template<uint kCount> class PlanarBlockStorage;
+template<uint kCount, uint kSectionSize> class SectionedBlockStorage;
 
 class Block {
   friend class BlockDef;
   friend class Chunk;
+  template<uint kCount> friend class DenseBlockStorage;
+  template<uint kCount> friend class PaletteBlockStorage;
+  template<uint kCount> friend class PlanarBlockStorage;
+  template<uint kCount, uint kSectionSize> friend class SectionedBlockStorage;
 public:
   static constexpr uint8_t kOpaqueFlag = BIT_FLAG(0);
   static constexpr uint8_t kLightDirtyFlag  = BIT_FLAG(1);
@@ -18,10 +27,15 @@ public:
   static constexpr uint8_t kMaxOutdoorLight  = 0x0f;
 
   block_id_t id() const { return mType; }
+  // the full definition, hot loops want `BlockProperties` instead
   const BlockDef& type() const;
+  uint8_t emissive() const { return BlockProperties::emissive(mType); }
   bool opaque() const { return mBitFlags & kOpaqueFlag; }
   bool lightDirty() const  { return mBitFlags & kLightDirtyFlag;  }
 
+  uint8_t light() const { return mLight; }
+  uint8_t bitFlags() const { return mBitFlags; }
+
   uint8_t indoorLight() const { return mLight & kIndoorLightMask; }
   uint8_t outdoorLight() const { return (mLight & kOutdoorLightMask) >> 4; }
 
@@ -2,51 +2,124 @@
 #include "Engine/Math/Primitives/uvec2.hpp"
 #include "Engine/Math/Primitives/aabb2.hpp"
 #include "Game/World/Block.hpp"
+#include "Game/World/BlockProperties.hpp"
 #include "Engine/Debug/ErrorWarningAssert.hpp"
 #include "Engine/Renderer/Shader/ShaderInterop.h"
+#include "Engine/File/FileSystem.hpp"
+#include "Engine/File/Utils.hpp"
+#include "Engine/Debug/Log.hpp"
 
-#define CI(x,y) spriteCoordsToIndex(x,y)
-
-std::array<BlockDef, BlockDef::kTotalBlockDef> BlockDef::sBlockDefs = {
-  BlockDef{0, false, 0, "air", {CI(0,0), CI(0,0), CI(0,0)}},
-  BlockDef{1, true, 0, "grass", {CI(21,0), CI(3,3), CI(4, 3)}},
-  BlockDef{2, true, 0,"dust", {CI(4, 3), CI(4, 3), CI(4, 3)}},
-  BlockDef{3, true, 0, "stone", {CI(1, 4), CI(1, 4), CI(1, 4)}},
-  BlockDef{4, true, 0xf, "light", {CI(3, 13), CI(3, 13), CI(3, 13)}}
-};
-
-#undef CI
+// filled by loadDefinitions from kDefinitionPath
+std::array<BlockDef, BlockDef::kTotalBlockDef> BlockDef::sBlockDefs = {};
+std::array<uint16_t, BlockDef::kNameTableSize> BlockDef::sNameTable = {};
 
 RHIBuffer::sptr_t BlockDef::sBlockDefBuffer = nullptr;
 
+// just enough xml for flat definition files, `<Tag attr="value" ... />`
+template<typename Visitor>
+static void forEachXmlElement(std::string_view xml, std::string_view tag, Visitor&& visit) {
+  size_t at = 0;
+  while((at = xml.find('<', at)) != std::string_view::npos) {
+    size_t end = xml.find('>', at);
+    if(end == std::string_view::npos) return;
+
+    std::string_view element = xml.substr(at + 1, end - at - 1);
+    at = end;
+
+    // `<BlockDefinitions>` shares the prefix with `<BlockDefinition`
+    if(element.substr(0, tag.size()) != tag) continue;
+    if(element.size() > tag.size() && !isspace((unsigned char)element[tag.size()])) continue;
+    visit(element);
+  }
+}
 
+static std::string_view xmlAttribute(std::string_view element, std::string_view name) {
+  size_t at = 0;
+  while((at = element.find(name, at)) != std::string_view::npos) {
+    size_t eq = at + name.size();
+    bool wordStart = at > 0 && isspace((unsigned char)element[at - 1]);
+    if(wordStart && eq + 1 < element.size() && element[eq] == '=' && element[eq + 1] == '"') {
+      size_t end = element.find('"', eq + 2);
+      if(end == std::string_view::npos) return {};
+      return element.substr(eq + 2, end - eq - 2);
+    }
+    at = eq;
+  }
+  return {};
+}
 
-BlockDef::BlockDef() {
-  for(uint face = 0; face < NUM_FACE; face++) {
-    uvec2 coords = spriteIndexToCoords(mSpriteIndex[face]);
+static int xmlInt(std::string_view element, std::string_view name, int defaultValue) {
+  std::string_view value = xmlAttribute(element, name);
+  return value.empty() ? defaultValue : atoi(std::string(value).c_str());
+}
 
-    vec2 mins{kSpritesheetUnitU * coords.x, kSpritesheetUnitV * coords.y + kSpritesheetUnitV};
-    vec2 maxs = mins + vec2{ kSpritesheetUnitU, -kSpritesheetUnitV };
+static uint xmlSprite(std::string_view element, std::string_view name) {
+  std::string value(xmlAttribute(element, name));
+  uint x = 0, y = 0;
+  if(sscanf(value.c_str(), "%u,%u", &x, &y) != 2) {
+    Log::logf("block definition sprite `%s` is not `x,y`, falls back to 0,0", value.c_str());
+  }
+  return BlockDef::spriteCoordsToIndex(x, y);
+}
 
-    mSpriteUVs[face] = { mins, maxs };
+uint BlockDef::nameHash(std::string_view name) {
+  // fnv-1a
+  uint hash = 2166136261u;
+  for(char c: name) {
+    hash = (hash ^ uint8_t(c)) * 16777619u;
   }
+  return hash;
+}
+
+void BlockDef::loadDefinitions(std::string_view xml) {
+  sBlockDefs = {};
+  sNameTable = {};
+  BlockProperties::clear();
+
+  forEachXmlElement(xml, "BlockDefinition", [](std::string_view element) {
+    int id = xmlInt(element, "id", -1);
+    std::string_view name = xmlAttribute(element, "name");
+    EXPECTS(id >= 0 && id < int(kTotalBlockDef));
+    EXPECTS(!name.empty());
+    EXPECTS(get(name) == nullptr);
+
+    sBlockDefs[id] = BlockDef{
+      block_id_t(id), 
+      xmlAttribute(element, "opaque") == "true", 
+      uint8_t(xmlInt(element, "emissive", 0)), 
+      name, 
+      { xmlSprite(element, "spriteTop"), xmlSprite(element, "spriteSide"), xmlSprite(element, "spriteBottom") },
+      uint8_t(std::max(xmlInt(element, "attenuation", 1), 1))
+    };
+    BlockProperties::set(sBlockDefs[id]);
+
+    uint slot = nameHash(name) & (kNameTableSize - 1);
+    while(sNameTable[slot] != 0) slot = (slot + 1) & (kNameTableSize - 1);
+    sNameTable[slot] = uint16_t(id + 1);
+  });
 }
 
-BlockDef::BlockDef(block_id_t id, bool opaque, uint8_t emissiveAmount, std::string_view name, const std::array<uint, NUM_FACE>& spriteIndexs)
-: mTypeId(id), mOpaque(opaque), mEmissiveAmount(emissiveAmount), mName(name), mSpriteIndex{spriteIndexs} {
-  for(uint face = 0; face < NUM_FACE; face++) {
-    uvec2 coords = spriteIndexToCoords(mSpriteIndex[face]);
 
-    vec2 mins{kSpritesheetUnitU * coords.x, kSpritesheetUnitV * coords.y + kSpritesheetUnitV};
-    vec2 maxs = mins + vec2{ kSpritesheetUnitU, -kSpritesheetUnitV };
+BlockDef::BlockDef() {
+  for(uint face = 0; face < NUM_FACE; face++) {
+    mSpriteUVs[face] = spriteUVs(mSpriteIndex[face]);
+  }
+}
 
-    mSpriteUVs[face] = { mins, maxs };
+BlockDef::BlockDef(block_id_t id, bool opaque, uint8_t emissiveAmount, std::string_view name, const std::array<uint, NUM_FACE>& spriteIndexs, uint8_t attenuation)
+: mTypeId(id), mOpaque(opaque), mEmissiveAmount(emissiveAmount), mAttenuation(attenuation), mName(name), mSpriteIndex{spriteIndexs} {
+  for(uint face = 0; face < NUM_FACE; face++) {
+    mSpriteUVs[face] = spriteUVs(mSpriteIndex[face]);
   }
 }
 
 BlockDef* BlockDef::get(std::string_view defName) {
-  for(auto& blockDef: sBlockDefs) {
-    if(blockDef.mName == defName) return &blockDef;
+  // the table is at most half full, there is always an empty slot to stop at
+  uint slot = nameHash(defName) & (kNameTableSize - 1);
+  while(sNameTable[slot] != 0) {
+    BlockDef& def = sBlockDefs[sNameTable[slot] - 1];
+    if(def.mName == defName) return &def;
+    slot = (slot + 1) & (kNameTableSize - 1);
   }
   return nullptr;
 }
@@ -56,6 +129,14 @@ BlockDef* BlockDef::get(block_id_t id) {
   return &sBlockDefs[id];
 }
 
+aabb2 BlockDef::spriteUVs(uint index) {
+  uvec2 coords = spriteIndexToCoords(index);
+
+  vec2 mins{kSpritesheetUnitU * coords.x, kSpritesheetUnitV * coords.y + kSpritesheetUnitV};
+  vec2 maxs = mins + vec2{ kSpritesheetUnitU, -kSpritesheetUnitV };
+  return { mins, maxs };
+}
+
 uvec2  BlockDef::spriteIndexToCoords(uint index) {
   auto result = std::div(long(index), long(kSpritesheetUnitCountX));
   return {uint(result.rem), uint(result.quot)};
@@ -78,6 +159,15 @@ struct BlockDefGPU {
 };
 
 void BlockDef::init() {
+  auto physicalPaths = FileSystem::Get().map(kDefinitionPath);
+  // should only map to one file
+  EXPECTS(physicalPaths.size() == 1);
+
+  Blob data = fs::read(physicalPaths[0]);
+  byte_t* text = data;
+  loadDefinitions({ (const char*)text, data.size() });
+
+  // the gpu table mirrors sBlockDefs, ids index both
   std::array<BlockDefGPU, kTotalBlockDef> defs;
   memset(defs.data(), 0, sizeof(defs));
 
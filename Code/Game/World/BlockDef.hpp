@@ -12,6 +12,7 @@ using block_id_t = uint8_t;
 class BlockDef {
 public:
   static constexpr size_t kTotalBlockDef = size_t(block_id_t(-1)) + 1u;
+  static constexpr const char* kDefinitionPath = "/Data/Definitions/Blocks.xml";
   static constexpr float kSpritesheetSizeX = 1024;
   static constexpr float kSpritesheetSizeY = 1024;
 
@@ -28,28 +29,41 @@ public:
   };
 
   BlockDef();
-  BlockDef(block_id_t id, bool opaque, uint8_t emissiveAmount, std::string_view name, const std::array<uint, NUM_FACE>& spriteIndexs);
+  BlockDef(block_id_t id, bool opaque, uint8_t emissiveAmount, std::string_view name, const std::array<uint, NUM_FACE>& spriteIndexs, uint8_t attenuation = 1);
 
   const aabb2& uvs(eFace face) const {
     return mSpriteUVs[face];
   };
+  uint spriteIndex(eFace face) const { return mSpriteIndex[face]; }
   block_id_t id() const { return mTypeId; }
   bool opaque() const { return mOpaque; }
   uint8_t emissive() const { return mEmissiveAmount; }
+  uint8_t attenuation() const { return mAttenuation; }
 
+  // resolve names once outside of hot loops, it is a hash probe but still a string compare
   static BlockDef* get(std::string_view defName);
   static BlockDef* get(block_id_t id);
   static constexpr uint spriteCoordsToIndex(uint x, uint y) { return x + y * (uint)kSpritesheetUnitCountX; }
 
   static uvec2 spriteIndexToCoords(uint index);
+  // the sprite's rect in the atlas, mins at the bottom left
+  static aabb2 spriteUVs(uint index);
   Block instantiate() const;
   static void init();
+  static void loadDefinitions(std::string_view xml);
   static RHIBuffer::sptr_t sBlockDefBuffer;
 protected:
+  // open addressing on the name hash, slots hold id + 1 so zero is empty
+  static constexpr size_t kNameTableSize = kTotalBlockDef * 2;
+  static_assert((kNameTableSize & (kNameTableSize - 1)) == 0, "probing wraps with a mask");
+  static uint nameHash(std::string_view name);
+
   static std::array<BlockDef, kTotalBlockDef> sBlockDefs;
+  static std::array<uint16_t, kNameTableSize> sNameTable;
   block_id_t mTypeId = 255;
   std::string mName = "invalid";
   uint8_t mEmissiveAmount = 0;
+  uint8_t mAttenuation = 1;
   bool mOpaque = false;
   std::array<uint, NUM_FACE> mSpriteIndex = { 255 };
   std::array<aabb2, NUM_FACE> mSpriteUVs;
@@ -0,0 +1,23 @@
+#include "BlockProperties.hpp"
+
+std::array<uint64_t, BlockProperties::kWordCount> BlockProperties::sOpaque = {};
+std::array<uint64_t, BlockProperties::kWordCount> BlockProperties::sEmitter = {};
+std::array<uint8_t, BlockProperties::kCount> BlockProperties::sEmissive = {};
+std::array<uint8_t, BlockProperties::kCount> BlockProperties::sAttenuation = {};
+
+void BlockProperties::clear() {
+  sOpaque = {};
+  sEmitter = {};
+  sEmissive = {};
+  sAttenuation.fill(1);
+}
+
+void BlockProperties::set(const BlockDef& def) {
+  block_id_t id = def.id();
+  uint64_t bit = uint64_t(1) << (id & 63);
+
+  sOpaque[id >> 6] = def.opaque() ? (sOpaque[id >> 6] | bit) : (sOpaque[id >> 6] & ~bit);
+  sEmitter[id >> 6] = def.emissive() > 0 ? (sEmitter[id >> 6] | bit) : (sEmitter[id >> 6] & ~bit);
+  sEmissive[id] = def.emissive();
+  sAttenuation[id] = def.attenuation();
+}
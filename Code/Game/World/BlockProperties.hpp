@@ -0,0 +1,32 @@
+#pragma once
+#include "Engine/Core/common.hpp"
+#include "Game/World/BlockDef.hpp"
+
+// the per id properties lighting and collision read for every block, packed in a few cache lines.
+// `BlockDef` stays the source of truth, `BlockDef::loadDefinitions` fills this from it
+class BlockProperties {
+public:
+  static constexpr size_t kCount = BlockDef::kTotalBlockDef;
+
+  static bool opaque(block_id_t id) { return (sOpaque[id >> 6] >> (id & 63)) & 1u; }
+  static bool emitter(block_id_t id) { return (sEmitter[id >> 6] >> (id & 63)) & 1u; }
+  static uint8_t emissive(block_id_t id) { return sEmissive[id]; }
+  // how much light drops stepping into a block of this type
+  static uint8_t attenuation(block_id_t id) { return sAttenuation[id]; }
+
+  static void clear();
+  static void set(const BlockDef& def);
+
+  static constexpr size_t memoryUsage() {
+    return sizeof(sOpaque) + sizeof(sEmitter) + sizeof(sEmissive) + sizeof(sAttenuation);
+  }
+
+protected:
+  static constexpr size_t kWordCount = kCount / 64;
+  static_assert(kCount % 64 == 0, "ids are packed 64 per word");
+
+  static std::array<uint64_t, kWordCount> sOpaque;
+  static std::array<uint64_t, kWordCount> sEmitter;
+  static std::array<uint8_t, kCount> sEmissive;
+  static std::array<uint8_t, kCount> sAttenuation;
+};
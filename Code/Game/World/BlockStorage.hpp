@@ -0,0 +1,536 @@
+#pragma once
+#include <memory>
+#include "Engine/Core/common.hpp"
+#include "Game/World/Block.hpp"
+
+/*
+ * How a chunk keeps its blocks in memory, picked at compile time.
+ *   DENSE:   one 4 bytes `Block` per voxel, same layout the gpu volume consumes.
+ *   PALETTE: a small palette of (block id, static flags) plus bit-packed palette indices. The indices
+ *            start at 0 bit (uniform) and widen to 1/2/4/8 bits when more distinct types show up.
+ *            Light stays one byte per block. Light-dirty is not kept, `SectionedBlockStorage` has its own.
+ *   PLANAR:  structure of arrays, one byte plane each for ids, light and flags. A scan that only needs
+ *            one field (opacity for meshing, ids for serialization) streams a single dense byte array.
+ * All of them expose the same per-field interface, `Chunk::BlockRef` sits on top of it.
+ * A chunk does not use them directly, it is cut into sections by `SectionedBlockStorage`, see below.
+ */
+#define BLOCK_STORAGE_DENSE   0
+#define BLOCK_STORAGE_PALETTE 1
+#define BLOCK_STORAGE_PLANAR  2
+
+#ifndef BLOCK_STORAGE_MODE
+#define BLOCK_STORAGE_MODE BLOCK_STORAGE_DENSE
+#endif
+
+template<uint kCount>
+class DenseBlockStorage {
+public:
+  static constexpr const char* kName = "dense";
+
+  block_id_t id(uint index) const { return mBlocks[index].mType; }
+  uint8_t light(uint index) const { return mBlocks[index].mLight; }
+  uint8_t flags(uint index) const { return mBlocks[index].mBitFlags; }
+
+  void setLight(uint index, uint8_t light) { mBlocks[index].mLight = light; }
+  void setFlags(uint index, uint8_t flags) { mBlocks[index].mBitFlags = flags; }
+  void reset(uint index, block_id_t id, uint8_t flags) {
+    mBlocks[index].mType = id;
+    mBlocks[index].mBitFlags = flags;
+  }
+
+  Block get(uint index) const { return mBlocks[index]; }
+
+  // every block at once, light is reset
+  void assign(const block_id_t* ids, const uint8_t* flags) {
+    for(uint i = 0; i < kCount; i++) {
+      mBlocks[i].mType = ids[i];
+      mBlocks[i].mLight = 0;
+      mBlocks[i].mBitFlags = flags[i];
+    }
+  }
+
+  // already in gpu layout, the scratch is not touched
+  Block* gpuData(std::vector<Block>& /*scratch*/) { return mBlocks.data(); }
+
+  size_t memoryUsage() const { return sizeof(*this); }
+
+protected:
+  std::array<Block, kCount> mBlocks;
+};
+
+template<uint kCount>
+class PaletteBlockStorage {
+public:
+  static constexpr const char* kName = "palette";
+  static constexpr uint kMaxBitsPerIndex = sizeof(block_id_t) * 8;
+  static constexpr uint kMaxPaletteSize = 1u << kMaxBitsPerIndex;
+
+  PaletteBlockStorage() {
+    // match the default constructed `Block`
+    mPalette.push_back(Block().id());
+    mPaletteFlags.push_back(Block().bitFlags());
+    mLight.fill(0);
+  }
+
+  // flags are the static ones only, a light-dirty bit passed in is dropped
+  block_id_t id(uint index) const { return mPalette[paletteIndex(index)]; }
+  uint8_t light(uint index) const { return mLight[index]; }
+  uint8_t flags(uint index) const { return mPaletteFlags[paletteIndex(index)]; }
+
+  void setLight(uint index, uint8_t light) { mLight[index] = light; }
+  void setFlags(uint index, uint8_t flags) {
+    // only touch the palette when the flags change
+    uint8_t staticFlags = flags & ~Block::kLightDirtyFlag;
+    uint current = paletteIndex(index);
+    if(mPaletteFlags[current] != staticFlags) {
+      setPaletteIndex(index, findOrAddPaletteEntry(mPalette[current], staticFlags));
+    }
+  }
+  void reset(uint index, block_id_t id, uint8_t flags) {
+    setPaletteIndex(index, findOrAddPaletteEntry(id, flags & ~Block::kLightDirtyFlag));
+  }
+
+  Block get(uint index) const {
+    Block b;
+    b.mType = id(index);
+    b.mLight = light(index);
+    b.mBitFlags = flags(index);
+    return b;
+  }
+
+  // every block at once, light is reset. the palette is collected first so the indices are packed
+  // once at their final width instead of widening along the way
+  void assign(const block_id_t* ids, const uint8_t* flags) {
+    mPalette.clear();
+    mPaletteFlags.clear();
+    mLight.fill(0);
+
+    // runs are long, remember the last entry
+    uint last = 0;
+    auto lookup = [&](uint i) {
+      if(last < mPalette.size() && mPalette[last] == ids[i] && mPaletteFlags[last] == flags[i]) return last;
+      for(last = 0; last < mPalette.size(); last++) {
+        if(mPalette[last] == ids[i] && mPaletteFlags[last] == flags[i]) return last;
+      }
+      ENSURES(mPalette.size() < kMaxPaletteSize);
+      mPalette.push_back(ids[i]);
+      mPaletteFlags.push_back(flags[i]);
+      return last;
+    };
+
+    for(uint i = 0; i < kCount; i++) lookup(i);
+
+    uint bits = 0;
+    while((1u << bits) < mPalette.size()) bits = bits == 0 ? 1 : bits << 1;
+    mBitsPerIndex = bits;
+    mIndices.assign((size_t(kCount) * bits + 63) / 64, 0);
+    if(bits == 0) return;
+
+    for(uint i = 0; i < kCount; i++) {
+      uint bit = i * bits;
+      mIndices[bit >> 6] |= uint64_t(lookup(i)) << (bit & 63);
+    }
+  }
+
+  Block* gpuData(std::vector<Block>& scratch) {
+    scratch.resize(kCount);
+    for(uint i = 0; i < kCount; i++) {
+      scratch[i] = get(i);
+    }
+    return scratch.data();
+  }
+
+  size_t memoryUsage() const {
+    return sizeof(*this)
+         + mPalette.capacity() * sizeof(block_id_t)
+         + mPaletteFlags.capacity() * sizeof(uint8_t)
+         + mIndices.capacity() * sizeof(uint64_t);
+  }
+
+  uint bitsPerIndex() const { return mBitsPerIndex; }
+  uint paletteSize() const { return (uint)mPalette.size(); }
+
+protected:
+  uint paletteIndex(uint index) const {
+    if(mBitsPerIndex == 0) return 0;
+    uint bit = index * mBitsPerIndex;
+    return uint(mIndices[bit >> 6] >> (bit & 63)) & ((1u << mBitsPerIndex) - 1u);
+  }
+
+  void setPaletteIndex(uint index, uint pi) {
+    if(mBitsPerIndex == 0) return; // single entry palette, `pi` can only be 0
+    uint bit = index * mBitsPerIndex;
+    uint64_t mask = ((1ull << mBitsPerIndex) - 1ull) << (bit & 63);
+    uint64_t& word = mIndices[bit >> 6];
+    word = (word & ~mask) | ((uint64_t(pi) << (bit & 63)) & mask);
+  }
+
+  uint findOrAddPaletteEntry(block_id_t id, uint8_t staticFlags) {
+    for(uint i = 0; i < mPalette.size(); i++) {
+      if(mPalette[i] == id && mPaletteFlags[i] == staticFlags) return i;
+    }
+
+    ENSURES(mPalette.size() < kMaxPaletteSize);
+    mPalette.push_back(id);
+    mPaletteFlags.push_back(staticFlags);
+
+    if(mPalette.size() > (1u << mBitsPerIndex)) {
+      uint bits = mBitsPerIndex == 0 ? 1 : mBitsPerIndex;
+      while((1u << bits) < mPalette.size()) bits = bits << 1;
+      widen(bits);
+    }
+    return uint(mPalette.size() - 1);
+  }
+
+  // entries never straddle two words since the width is always a power of 2
+  void widen(uint bitsPerIndex) {
+    EXPECTS(bitsPerIndex <= kMaxBitsPerIndex);
+    std::vector<uint64_t> indices((size_t(kCount) * bitsPerIndex + 63) / 64, 0);
+    for(uint i = 0; i < kCount; i++) {
+      uint64_t pi = paletteIndex(i);
+      uint bit = i * bitsPerIndex;
+      indices[bit >> 6] |= pi << (bit & 63);
+    }
+    mIndices.swap(indices);
+    mBitsPerIndex = bitsPerIndex;
+  }
+
+  std::vector<block_id_t> mPalette;
+  std::vector<uint8_t> mPaletteFlags;
+  std::vector<uint64_t> mIndices;
+  uint mBitsPerIndex = 0;
+  std::array<uint8_t, kCount> mLight;
+};
+
+template<uint kCount>
+class PlanarBlockStorage {
+public:
+  static constexpr const char* kName = "planar";
+
+  PlanarBlockStorage() {
+    // match the default constructed `Block`
+    mIds.fill(Block().id());
+    mLight.fill(Block().light());
+    mFlags.fill(Block().bitFlags());
+  }
+
+  block_id_t id(uint index) const { return mIds[index]; }
+  uint8_t light(uint index) const { return mLight[index]; }
+  uint8_t flags(uint index) const { return mFlags[index]; }
+
+  void setLight(uint index, uint8_t light) { mLight[index] = light; }
+  void setFlags(uint index, uint8_t flags) { mFlags[index] = flags; }
+  void reset(uint index, block_id_t id, uint8_t flags) {
+    mIds[index] = id;
+    mFlags[index] = flags;
+  }
+
+  Block get(uint index) const {
+    Block b;
+    b.mType = mIds[index];
+    b.mLight = mLight[index];
+    b.mBitFlags = mFlags[index];
+    return b;
+  }
+
+  // every block at once, light is reset
+  void assign(const block_id_t* ids, const uint8_t* flags) {
+    memcpy(mIds.data(), ids, sizeof(mIds));
+    memcpy(mFlags.data(), flags, sizeof(mFlags));
+    mLight.fill(0);
+  }
+
+  Block* gpuData(std::vector<Block>& scratch) {
+    scratch.resize(kCount);
+    for(uint i = 0; i < kCount; i++) {
+      scratch[i] = get(i);
+    }
+    return scratch.data();
+  }
+
+  size_t memoryUsage() const { return sizeof(*this); }
+
+protected:
+  std::array<block_id_t, kCount> mIds;
+  std::array<uint8_t, kCount> mLight;
+  std::array<uint8_t, kCount> mFlags;
+};
+
+#if BLOCK_STORAGE_MODE == BLOCK_STORAGE_PALETTE
+template<uint kCount> using BlockStorage = PaletteBlockStorage<kCount>;
+#elif BLOCK_STORAGE_MODE == BLOCK_STORAGE_PLANAR
+template<uint kCount> using BlockStorage = PlanarBlockStorage<kCount>;
+#else
+template<uint kCount> using BlockStorage = DenseBlockStorage<kCount>;
+#endif
+
+/*
+ * `kCount` blocks cut into sections of `kSectionSize` consecutive indices. A section is either uniform,
+ * one block value for all of it, or backed by a full `BlockStorage<kSectionSize>`. Writing a different
+ * value into a uniform section materializes it, `compact` folds it back once it is uniform again.
+ * Light-dirty is transient bookkeeping and lives in its own bit set, so light propagation passing through
+ * a section does not force it to materialize.
+ * Sections are shared copy-on-write with the `View`s taken from the storage: a writer clones a section
+ * that is still referenced by a view before touching it, so a view never changes once taken. Views have
+ * to be taken on the thread that writes the storage.
+ */
+template<uint kCount, uint kSectionSize>
+class SectionedBlockStorage {
+public:
+  using Section = BlockStorage<kSectionSize>;
+
+  static constexpr const char* kName = Section::kName;
+  static constexpr uint kSectionCount = kCount / kSectionSize;
+  static_assert(kSectionCount * kSectionSize == kCount, "sections have to tile the storage");
+
+  // immutable, light-dirty not included
+  class View {
+    friend class SectionedBlockStorage;
+  public:
+    block_id_t id(uint index) const {
+      const Section* section = mSections[sectionOf(index)].get();
+      return section != nullptr ? section->id(localOf(index)) : mUniform[sectionOf(index)].mType;
+    }
+    uint8_t light(uint index) const {
+      const Section* section = mSections[sectionOf(index)].get();
+      return section != nullptr ? section->light(localOf(index)) : mUniform[sectionOf(index)].mLight;
+    }
+    uint8_t flags(uint index) const {
+      const Section* section = mSections[sectionOf(index)].get();
+      return section != nullptr ? section->flags(localOf(index)) : mUniform[sectionOf(index)].mBitFlags;
+    }
+    Block get(uint index) const {
+      const Section* section = mSections[sectionOf(index)].get();
+      return section != nullptr ? section->get(localOf(index)) : mUniform[sectionOf(index)];
+    }
+
+    bool uniform(uint section) const { return mSections[section] == nullptr; }
+    const Block& uniformBlock(uint section) const {
+      EXPECTS(uniform(section));
+      return mUniform[section];
+    }
+
+  protected:
+    std::array<std::shared_ptr<const Section>, kSectionCount> mSections;
+    std::array<Block, kSectionCount> mUniform;
+  };
+
+  View view() const {
+    View v;
+    for(uint s = 0; s < kSectionCount; s++) {
+      v.mSections[s] = mSections[s];
+    }
+    v.mUniform = mUniform;
+    return v;
+  }
+
+  block_id_t id(uint index) const {
+    const Section* section = mSections[sectionOf(index)].get();
+    return section != nullptr ? section->id(localOf(index)) : mUniform[sectionOf(index)].mType;
+  }
+  uint8_t light(uint index) const {
+    const Section* section = mSections[sectionOf(index)].get();
+    return section != nullptr ? section->light(localOf(index)) : mUniform[sectionOf(index)].mLight;
+  }
+  uint8_t flags(uint index) const {
+    const Section* section = mSections[sectionOf(index)].get();
+    uint8_t staticFlags = section != nullptr ? section->flags(localOf(index)) : mUniform[sectionOf(index)].mBitFlags;
+    return staticFlags | (lightDirty(index) ? Block::kLightDirtyFlag : 0);
+  }
+
+  void setLight(uint index, uint8_t light) {
+    uint s = sectionOf(index);
+    if(mSections[s] == nullptr) {
+      if(mUniform[s].mLight == light) return;
+      materialize(s);
+    }
+    writable(s).setLight(localOf(index), light);
+  }
+  void setFlags(uint index, uint8_t flags) {
+    setLightDirty(index, flags & Block::kLightDirtyFlag);
+
+    uint s = sectionOf(index);
+    uint8_t staticFlags = flags & ~Block::kLightDirtyFlag;
+    if(mSections[s] == nullptr) {
+      if(mUniform[s].mBitFlags == staticFlags) return;
+      materialize(s);
+    }
+    if(mSections[s]->flags(localOf(index)) == staticFlags) return;
+    writable(s).setFlags(localOf(index), staticFlags);
+  }
+  void reset(uint index, block_id_t id, uint8_t flags) {
+    setLightDirty(index, flags & Block::kLightDirtyFlag);
+
+    uint s = sectionOf(index);
+    uint8_t staticFlags = flags & ~Block::kLightDirtyFlag;
+    if(mSections[s] == nullptr) {
+      if(mUniform[s].mType == id && mUniform[s].mBitFlags == staticFlags) return;
+      materialize(s);
+    }
+    writable(s).reset(localOf(index), id, staticFlags);
+  }
+
+  Block get(uint index) const {
+    const Section* section = mSections[sectionOf(index)].get();
+    Block b = section != nullptr ? section->get(localOf(index)) : mUniform[sectionOf(index)];
+    b.mBitFlags |= lightDirty(index) ? Block::kLightDirtyFlag : 0;
+    return b;
+  }
+
+  // only `sections` are unpacked again, the rest of `scratch` is taken to be from the last call
+  Block* gpuData(std::vector<Block>& scratch, uint32_t sections = ~0u) {
+    if(scratch.size() != kCount) {
+      scratch.resize(kCount);
+      sections = ~0u;
+    }
+    std::vector<Block> sectionScratch;
+    for(uint s = 0; s < kSectionCount; s++) {
+      if((sections & (1u << s)) == 0) continue;
+      Block* dst = scratch.data() + s * kSectionSize;
+      if(mSections[s] == nullptr) {
+        std::fill(dst, dst + kSectionSize, mUniform[s]);
+      } else {
+        const Block* src = mSections[s]->gpuData(sectionScratch);
+        std::copy(src, src + kSectionSize, dst);
+      }
+    }
+
+    // most words are empty, only the set bits need patching
+    static_assert(kSectionSize % 64 == 0, "light-dirty words don't cross sections");
+    for(uint w = 0; w < mLightDirty.size(); w++) {
+      if((sections & (1u << (w * 64 / kSectionSize))) == 0) continue;
+      for(uint64_t bits = mLightDirty[w]; bits != 0; bits &= bits - 1) {
+        uint bit = 0;
+        while(((bits >> bit) & 1ull) == 0) bit++;
+        scratch[w * 64 + bit].mBitFlags |= Block::kLightDirtyFlag;
+      }
+    }
+    return scratch.data();
+  }
+
+  size_t memoryUsage() const {
+    size_t usage = sizeof(*this);
+    for(const std::shared_ptr<Section>& section: mSections) {
+      if(section != nullptr) usage += section->memoryUsage();
+    }
+    return usage;
+  }
+
+  // section level access, uniform sections are what the chunk passes skip
+  bool uniform(uint section) const { return mSections[section] == nullptr; }
+  uint uniformSectionCount() const {
+    uint count = 0;
+    for(const std::shared_ptr<Section>& section: mSections) count += section == nullptr ? 1 : 0;
+    return count;
+  }
+
+  // the value of a uniform section, light-dirty not included
+  const Block& uniformBlock(uint section) const {
+    EXPECTS(uniform(section));
+    return mUniform[section];
+  }
+
+  // turns the whole section into `id`, lighting of the section is reset
+  void fill(uint section, block_id_t id, uint8_t flags) {
+    clearSectionLightDirty(section);
+    mSections[section].reset();
+    mUniform[section].mType = id;
+    mUniform[section].mLight = 0;
+    mUniform[section].mBitFlags = flags & ~Block::kLightDirtyFlag;
+  }
+
+  // a whole section from ids and static flags in index order, lighting of the section is reset.
+  // goes straight to uniform when all the blocks are the same
+  void assign(uint section, const block_id_t* ids, const uint8_t* flags) {
+    bool same = true;
+    for(uint i = 1; i < kSectionSize && same; i++) {
+      same = ids[i] == ids[0] && flags[i] == flags[0];
+    }
+    if(same) {
+      fill(section, ids[0], flags[0]);
+      return;
+    }
+
+    // a fresh section, whatever a view still holds of the old one stays as it was
+    clearSectionLightDirty(section);
+    std::shared_ptr<Section> storage = std::make_shared<Section>();
+    storage->assign(ids, flags);
+    mSections[section] = std::move(storage);
+  }
+
+  void fillLight(uint section, uint8_t light) {
+    EXPECTS(uniform(section));
+    mUniform[section].mLight = light;
+  }
+
+  // fold the section back to uniform if every block in it holds the same value
+  bool compact(uint section) {
+    if(mSections[section] == nullptr) return true;
+
+    const Section& storage = *mSections[section];
+    block_id_t id = storage.id(0);
+    uint8_t light = storage.light(0);
+    uint8_t flags = storage.flags(0);
+    for(uint i = 1; i < kSectionSize; i++) {
+      if(storage.id(i) != id || storage.light(i) != light || storage.flags(i) != flags) return false;
+    }
+
+    mUniform[section].mType = id;
+    mUniform[section].mLight = light;
+    mUniform[section].mBitFlags = flags;
+    mSections[section].reset();
+    return true;
+  }
+
+  void compact() {
+    for(uint s = 0; s < kSectionCount; s++) {
+      compact(s);
+    }
+  }
+
+  // back to default blocks by dropping the sections, nothing is filled block by block
+  void clear() {
+    for(std::shared_ptr<Section>& section: mSections) {
+      section.reset();
+    }
+    mUniform.fill(Block());
+    mLightDirty.fill(0);
+  }
+
+protected:
+  static constexpr uint sectionOf(uint index) { return index / kSectionSize; }
+  static constexpr uint localOf(uint index) { return index % kSectionSize; }
+
+  void materialize(uint section) {
+    EXPECTS(mSections[section] == nullptr);
+    const Block& value = mUniform[section];
+    mSections[section] = std::make_shared<Section>();
+    for(uint i = 0; i < kSectionSize; i++) {
+      mSections[section]->reset(i, value.mType, value.mBitFlags);
+      mSections[section]->setLight(i, value.mLight);
+    }
+  }
+
+  // clone the section first if a view still holds it
+  Section& writable(uint section) {
+    if(mSections[section].use_count() > 1) {
+      mSections[section] = std::make_shared<Section>(*mSections[section]);
+    }
+    return *mSections[section];
+  }
+
+  bool lightDirty(uint index) const { return (mLightDirty[index >> 6] >> (index & 63)) & 1ull; }
+  void setLightDirty(uint index, bool dirty) {
+    uint64_t bit = 1ull << (index & 63);
+    mLightDirty[index >> 6] = dirty ? (mLightDirty[index >> 6] | bit) : (mLightDirty[index >> 6] & ~bit);
+  }
+
+  static_assert(kSectionSize % 64 == 0, "sections cover whole light-dirty words");
+  void clearSectionLightDirty(uint section) {
+    std::fill_n(mLightDirty.begin() + section * (kSectionSize / 64), kSectionSize / 64, 0ull);
+  }
+
+  std::array<std::shared_ptr<Section>, kSectionCount> mSections;
+  std::array<Block, kSectionCount> mUniform;
+  std::array<uint64_t, (kCount + 63) / 64> mLightDirty = {};
+};
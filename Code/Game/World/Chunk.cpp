@@ -1,10 +1,24 @@
 ﻿#include "Chunk.hpp"
 #include "Engine/Math/Noise/SmoothNoise.hpp"
+#include "Engine/Math/Noise/RawNoise.hpp"
 #include "Game/World/BlockDef.hpp"
+#include "Game/World/BlockProperties.hpp"
 #include "Engine/Math/Primitives/AABB2.hpp"
 #include <numeric>
+#include <limits>
+#include <algorithm>
+#include <cstddef>
 #include "Game/World/World.hpp"
+#include "Game/World/ChunkSnapshot.hpp"
+#include "Game/World/PaddedChunk.hpp"
+#include "Game/World/MesherPool.hpp"
 #include "Game/Utils/FileCache.hpp"
+#include "Game/Utils/PerlinGrid.hpp"
+#include "Game/Utils/Config.hpp"
+#include "Game/World/TerrainDensity.hpp"
+#include "Game/World/ClimateMap.hpp"
+#include "Game/World/PendingEdits.hpp"
+#include "Game/World/ChunkVertex.hpp"
 #include "Engine/Math/MathUtils.hpp"
 
 static constexpr int kDivNumMax = 32;
@@ -77,16 +91,43 @@ vec3 BlockCoords::blockCenterPosition(Chunk* chunk, BlockIndex index) {
 }
 
 bool ChunkCoords::operator>(const ChunkCoords& rhs) const {
+#if CUBIC_CHUNKS
+  if(z != rhs.z) return z > rhs.z;
+#endif
   return (y != rhs.y) ? (y > rhs.y)
     : ((x != rhs.x) ? (x > rhs.x) : false);
 }
 
 vec3 ChunkCoords::pivotPosition() {
+#if CUBIC_CHUNKS
+  return vec3{float(x*Chunk::kSizeX), float(y*Chunk::kSizeY), float(z*Chunk::kSizeZ)};
+#else
   return vec3{float(x*Chunk::kSizeX), float(y*Chunk::kSizeY), 0};
+#endif
 }
 
 ChunkCoords ChunkCoords::fromWorld(vec3 position) {
+#if CUBIC_CHUNKS
+  return { (int)floor(position.x / Chunk::kSizeX), (int)floor(position.y / Chunk::kSizeY), (int)floor(position.z / Chunk::kSizeZ) };
+#else
   return { (int)floor(position.x / Chunk::kSizeX) , (int)floor(position.y / Chunk::kSizeY) };
+#endif
+}
+
+ChunkCoords Chunk::neighborOffset(eNeighbor side) {
+  switch(side) {
+    case NEIGHBOR_POS_X: return { 1, 0};
+    case NEIGHBOR_NEG_X: return {-1, 0};
+    case NEIGHBOR_POS_Y: return { 0, 1};
+    case NEIGHBOR_NEG_Y: return { 0,-1};
+#if CUBIC_CHUNKS
+    case NEIGHBOR_POS_Z: return ChunkCoords{ ivec3{0, 0, 1} };
+    case NEIGHBOR_NEG_Z: return ChunkCoords{ ivec3{0, 0,-1} };
+#endif
+    default: ;
+  }
+  BAD_CODE_PATH();
+  return {};
 }
 
 Chunk::Chunk(ChunkCoords coords): mCoords(std::move(coords)) {
@@ -95,7 +136,37 @@ Chunk::Chunk(ChunkCoords coords): mCoords(std::move(coords)) {
 }
 
 Chunk::~Chunk() {
-  EXPECTS(mMesh == nullptr);  
+  for(Mesh* mesh: mSectionMeshes) {
+    EXPECTS(mesh == nullptr);  
+  }
+}
+
+void Chunk::recycle(ChunkCoords coords) {
+  EXPECTS(!mMeshed && mOwner == nullptr);
+
+  mCoords = coords;
+  mBounds = aabb3(coords.pivotPosition(), 
+                  coords.pivotPosition() + vec3{(float)kSizeX, (float)kSizeY, (float)kSizeZ});
+  mNeighbors.fill(&sInvalidChunk);
+  mSavePending = false;
+  mFedBy = 0;
+  mBorderEdits.clear();
+  mDirtySections = kAllSections;
+  mVolumeDirtySections = kAllSections;
+  mState = CHUNK_STATE_INIT_READY;
+
+  // blocks were freed on release. opacity masks are left as they are, loading or generating 
+  // rewrites every block before the chunk is registered
+}
+
+void Chunk::releaseMemory() {
+  for(Mesh*& mesh: mSectionMeshes) {
+    SAFE_DELETE(mesh);
+  }
+  mMeshed = false;
+  mChunkGPUData = nullptr;
+  mBlocks.clear();
+  mBorderEdits = {};
 }
 
 void Chunk::Iterator::step(eNeighbor dir) {
@@ -117,6 +188,13 @@ void Chunk::Iterator::step(const ChunkCoords& deltaCoords) {
     step(dirY);
   }
 
+#if CUBIC_CHUNKS
+  eNeighbor dirZ = deltaCoords.z > 0 ? NEIGHBOR_POS_Z : NEIGHBOR_NEG_Z;
+  for(int i = 0; i < abs(deltaCoords.z); i++) {
+    step(dirZ);
+  }
+#endif
+
 }
 
 Chunk::Iterator Chunk::Iterator::operator+(const ChunkCoords& deltaCoords) const {
@@ -172,6 +250,17 @@ void Chunk::BlockIter::step(const BlockCoords& deltaCoords) {
 
   BlockCoords current = BlockCoords::fromIndex(blockIndex);
 
+  ChunkCoords chunkShift;
+
+#if CUBIC_CHUNKS
+  {
+    // wrapping around the chunks, same as x and y
+    int expect = current.z + deltaCoords.z;
+    auto re      = quick_div(expect, kSizeBitZ);
+    current.z    = re.rem  ;
+    chunkShift.z = re.quot - (expect < 0);
+  }
+#else
   // check whether it's over the z bound
   current.z += deltaCoords.z;
   // deltaCoords.z = 0;
@@ -180,8 +269,8 @@ void Chunk::BlockIter::step(const BlockCoords& deltaCoords) {
     chunk = { sInvalidChunk };
     return;
   }
+#endif
 
-  ChunkCoords chunkShift;
   // if(int end = current.x + deltaCoords.x; end < kSizeX && end >=0) {
   //   chunkShift.x = 0;
   //   current.x = end;
@@ -211,12 +300,22 @@ void Chunk::BlockIter::step(const BlockCoords& deltaCoords) {
 
 }
 
+// one step along the axis owning `mask`, leaves the other axes alone whatever the index layout is.
+// the caller handles wrapping out of the chunk
+static inline BlockIndex maskedIncrement(BlockIndex index, BlockIndex mask) {
+  return BlockIndex((((index | ~mask) + 1) & mask) | (index & ~mask));
+}
+
+static inline BlockIndex maskedDecrement(BlockIndex index, BlockIndex mask) {
+  return BlockIndex((((index & mask) - 1) & mask) | (index & ~mask));
+}
+
 void Chunk::BlockIter::stepNegX() {
   if((blockIndex & kSizeMaskX) == 0) {
     blockIndex |= kSizeMaskX;
     chunk.step(NEIGHBOR_NEG_X);
   } else {
-    blockIndex -= 1;
+    blockIndex = maskedDecrement(blockIndex, kSizeMaskX);
   }
 }
 
@@ -225,7 +324,7 @@ void Chunk::BlockIter::stepPosX() {
     blockIndex &= ~kSizeMaskX;
     chunk.step(NEIGHBOR_POS_X);
   } else {
-    blockIndex += 1;
+    blockIndex = maskedIncrement(blockIndex, kSizeMaskX);
   }
 }
 
@@ -234,7 +333,7 @@ void Chunk::BlockIter::stepNegY() {
     blockIndex |= kSizeMaskY;
     chunk.step(NEIGHBOR_NEG_Y);
   } else {
-    blockIndex -= kSizeX;
+    blockIndex = maskedDecrement(blockIndex, kSizeMaskY);
   }
 }
 
@@ -243,25 +342,33 @@ void Chunk::BlockIter::stepPosY() {
     blockIndex &= ~kSizeMaskY;
     chunk.step(NEIGHBOR_POS_Y);
   } else {
-    blockIndex += kSizeX;
+    blockIndex = maskedIncrement(blockIndex, kSizeMaskY);
   }
 }
 
 void Chunk::BlockIter::stepPosZ() {
   if((blockIndex & kSizeMaskZ) == kSizeMaskZ) {
     blockIndex &= ~kSizeMaskZ;
+#if CUBIC_CHUNKS
+    chunk.step(NEIGHBOR_POS_Z);
+#else
     chunk = invalidIter();
+#endif
   } else {
-    blockIndex += kSizeX * kSizeY;
+    blockIndex = maskedIncrement(blockIndex, kSizeMaskZ);
   }
 }
 
 void Chunk::BlockIter::stepNegZ() {
   if((blockIndex & kSizeMaskZ) == 0) {
     blockIndex |= kSizeMaskZ;
+#if CUBIC_CHUNKS
+    chunk.step(NEIGHBOR_NEG_Z);
+#else
     chunk = invalidIter();
+#endif
   } else {
-    blockIndex -= kSizeX * kSizeY;
+    blockIndex = maskedDecrement(blockIndex, kSizeMaskZ);
   }
 }
 
@@ -271,61 +378,81 @@ bool Chunk::BlockIter::valid() const {
 
 void Chunk::BlockIter::reset(BlockDef& def) {
 
-  Block* b = block();
-  if(b == nullptr) return;
-
-  b->resetFromDef(def);
+  BlockRef b = block();
+  b.resetFromDef(def);
+  if(chunk.valid()) {
+    chunk->setOpaque(blockIndex, def.opaque());
+  }
 
-  chunk->setDirty();
+  // only the sections that can show one of its faces, across a chunk border that is the same section
+  chunk->setSectionsDirty(sectionsShowing(blockIndex));
+  uint32_t sameSection = 1u << (BlockCoords::fromIndex(blockIndex).z / kSectionSizeZ);
+  chunk->setVolumeDirty(sameSection);
   if((blockIndex & kSizeMaskX) == 0) {
     auto iter = chunk->neighbor(NEIGHBOR_NEG_X);
-    iter->setDirty();
+    iter->setSectionsDirty(sameSection);
   }
   if((blockIndex & kSizeMaskX) == kSizeMaskX) {
     auto iter = chunk->neighbor(NEIGHBOR_POS_X);
-    iter->setDirty();
+    iter->setSectionsDirty(sameSection);
   }
 
   if((blockIndex & kSizeMaskY) == 0) {
     auto iter = chunk->neighbor(NEIGHBOR_NEG_Y);
-    iter->setDirty();
+    iter->setSectionsDirty(sameSection);
   }
   if((blockIndex & kSizeMaskY) == kSizeMaskY) {
     auto iter = chunk->neighbor(NEIGHBOR_POS_Y);
-    iter->setDirty();
+    iter->setSectionsDirty(sameSection);
   }
+
+#if CUBIC_CHUNKS
+  if((blockIndex & kSizeMaskZ) == 0) {
+    auto iter = chunk->neighbor(NEIGHBOR_NEG_Z);
+    iter->setSectionsDirty(1u << (kSectionCount - 1));
+  }
+  if((blockIndex & kSizeMaskZ) == kSizeMaskZ) {
+    auto iter = chunk->neighbor(NEIGHBOR_POS_Z);
+    iter->setSectionsDirty(1u);
+  }
+#endif
 }
 
 void Chunk::BlockIter::dirtyLight() {
   chunk->markBlockLightDirty(*this);
 }
 
+bool Chunk::BlockIter::opaque() const {
+  return chunk->opaque(blockIndex);
+}
+
 Chunk::BlockIter Chunk::BlockIter::operator+(const BlockCoords& deltaCoords) const {
   BlockIter iter = *this;
   iter.step(deltaCoords);
   return iter;
 }
 
-Block& Chunk::BlockIter::operator*() const {
-  if(chunk.valid()) {
-    return chunk->block(blockIndex);
-  } else {
-    return Block::kInvalid;
-  }
+Chunk::BlockRef Chunk::BlockIter::operator*() const {
+  return block();
 }
 
-Block* Chunk::BlockIter::operator->() const {
+Chunk::BlockRef Chunk::BlockIter::operator->() const {
   return block();
 }
 
-Block* Chunk::BlockIter::block() const {
+Chunk::BlockRef Chunk::BlockIter::block() const {
   if(chunk.valid()) {
-    return &chunk->block(blockIndex);
+    return chunk->block(blockIndex);
   } else {
-    return &Block::kInvalid;
+    return { nullptr, blockIndex };
   } 
 }
 
+void Chunk::BlockRef::resetFromDef(const BlockDef& def) {
+  if(mStorage == nullptr) return;
+  mStorage->reset(mIndex, def.id(), def.opaque() ? Block::kOpaqueFlag : 0x0);
+}
+
 Chunk::BlockIter::BlockIter(Chunk& c, BlockCoords crds)
 : chunk(c), blockIndex(crds.toIndex()) {
 }
@@ -343,14 +470,14 @@ void Chunk::onInit() {
   // mMesher.end();
   // mMesh = mMesher.createMesh<vertex_lit_t>();
 
-  mIsDirty = true;
+  mDirtySections = kAllSections;
 
 
   // check 
   // if can load it from disk
   FileCache& cache = FileCache::get();
   if(!cache.load(*this)) {
-    generateBlocks();
+    generateBlocks(Config::kWorldSeed);
   }
   // if not, generate it
 
@@ -381,8 +508,8 @@ S<Job::Counter> Chunk::initAsync() {
 }
 
 S<Job::Counter> Chunk::generateBlockAsync() {
-  mIsDirty = true;
-  Job::Decl decl(this, &Chunk::generateBlocks);
+  mDirtySections = kAllSections;
+  Job::Decl decl(this, &Chunk::generateBlocks, Config::kWorldSeed);
   S<Job::Counter> generateBlockJob = Job::create(decl, Job::CAT_GENERIC);
   return generateBlockJob;
 }
@@ -395,7 +522,13 @@ void Chunk::onUpdate() {
 }
 
 void Chunk::onDestroy() {
-  SAFE_DELETE(mMesh);
+  for(Mesh*& mesh: mSectionMeshes) {
+    SAFE_DELETE(mesh);
+  }
+  mMeshed = false;
+  // a job still in flight finds its build outdated
+  mMeshGeneration++;
+  mMeshingSections = 0;
 
   if(mSavePending) {
     FileCache::get().save(*this);
@@ -406,47 +539,21 @@ void Chunk::onDestroy() {
 void Chunk::onRegisterToWorld(World* world) {
   mOwner = world;
   
-  // +x
-  {
-    Chunk* c = mOwner->findChunk(mCoords + ChunkCoords{1, 0});
-    setNeighbor(NEIGHBOR_POS_X, *c);
-    if(c->valid()) c->setNeighbor(NEIGHBOR_NEG_X, *this);
-  }
-
-  // -x
-  {
-    Chunk* c = mOwner->findChunk(mCoords + ChunkCoords{-1, 0});
-    setNeighbor(NEIGHBOR_NEG_X, *c);
-    if(c->valid()) c->setNeighbor(NEIGHBOR_POS_X, *this);
-  }
-
-  // +y
-  {
-    Chunk* c = mOwner->findChunk(mCoords + ChunkCoords{0, 1});
-    setNeighbor(NEIGHBOR_POS_Y, *c);
-    if(c->valid()) c->setNeighbor(NEIGHBOR_NEG_Y, *this);
-  }
-
-  // -y
-  {
-    Chunk* c = mOwner->findChunk(mCoords + ChunkCoords{0, -1});
-    setNeighbor(NEIGHBOR_NEG_Y, *c);
-    if(c->valid()) c->setNeighbor(NEIGHBOR_POS_Y, *this);
+  // link up both ways, +x -x +y -y (+z -z)
+  for(uint i = 0; i < NUM_NEIGHBOR; i++) {
+    eNeighbor side = eNeighbor(i);
+    Chunk* c = mOwner->findChunk(ChunkCoords(mCoords + neighborOffset(side)));
+    setNeighbor(side, *c);
+    if(c->valid()) c->setNeighbor(opposite(side), *this);
   }
 }
 
 void Chunk::onUnregisterFromWorld() {
-  if(mNeighbors[NEIGHBOR_POS_X]->valid()) {
-    mNeighbors[NEIGHBOR_POS_X]->setNeighbor(NEIGHBOR_NEG_X, sInvalidChunk);
-  }
-  if(mNeighbors[NEIGHBOR_NEG_X]->valid()) {
-    mNeighbors[NEIGHBOR_NEG_X]->setNeighbor(NEIGHBOR_POS_X, sInvalidChunk);
-  }
-  if(mNeighbors[NEIGHBOR_POS_Y]->valid()) {
-    mNeighbors[NEIGHBOR_POS_Y]->setNeighbor(NEIGHBOR_NEG_Y, sInvalidChunk);
-  }
-  if(mNeighbors[NEIGHBOR_NEG_Y]->valid()) {
-    mNeighbors[NEIGHBOR_NEG_Y]->setNeighbor(NEIGHBOR_POS_Y, sInvalidChunk);
+  for(uint i = 0; i < NUM_NEIGHBOR; i++) {
+    eNeighbor side = eNeighbor(i);
+    if(mNeighbors[side]->valid()) {
+      mNeighbors[side]->setNeighbor(opposite(side), sInvalidChunk);
+    }
   }
 
   mOwner = nullptr;
@@ -458,19 +565,33 @@ struct chunk_header_t {
   uint8_t chunkBitX = Chunk::kSizeBitX;
   uint8_t chunkBitY = Chunk::kSizeBitY;
   uint8_t chunkBitZ = Chunk::kSizeBitZ;
-  uint8_t reserved1 = 0;
+  uint8_t generator = TERRAIN_GENERATOR_MODE; // was reserved, heightmap saves from before read the same
   uint8_t reserved2 = 0;
   uint8_t reserved3 = 0;
   uint8_t format    = 'R';
+  // version 2 on, `Chunk::mFedBy`
+  uint32_t fedBy    = 0;
 
-  bool operator==(const chunk_header_t& rhs) const {
-    return memcmp(this, &rhs, sizeof(chunk_header_t)) == 0;
+  bool sameLayout(const chunk_header_t& rhs) const {
+    return memcmp(this, &rhs, offsetof(chunk_header_t, fedBy)) == 0;
   };
 };
 struct entry_t {
   uint8_t type = 0;
   uint8_t count = 0;
 };
+// after the runs up to the end of the data, one per `Chunk::mBorderEdits`. the block is linear like the runs,
+// the chunk it lands in is an offset from the saved one
+struct border_edit_t {
+  uint16_t linear = 0;
+  int8_t offset[3] = {};
+  block_id_t id = 0;
+};
+static_assert(Chunk::kTotalBlockCount <= 0x10000, "border edits keep the linear index in 16 bits");
+
+size_t Chunk::maxSerializedSize() const {
+  return sizeof(chunk_header_t) + kTotalBlockCount * sizeof(entry_t) + mBorderEdits.size() * sizeof(border_edit_t);
+}
 
 size_t Chunk::serialize(byte_t* data, size_t maxWrite) const {
 
@@ -478,27 +599,41 @@ size_t Chunk::serialize(byte_t* data, size_t maxWrite) const {
   // write header
   chunk_header_t* header = (chunk_header_t*)data;
   *header = chunk_header_t();
+  header->fedBy = mFedBy;
 
   entry_t* e = (entry_t*)(header+1);
   totalWrite += sizeof(chunk_header_t);
-  {
-    e->type = block(0).id();
-    e->count = 1;
-  }
+  e->count = 0;
+
   uint blockCount = 0;
-  for(uint i = 1; i < kTotalBlockCount; i++) {
-    const Block& b = block(i);
-    if(e->type != b.id() || e->count == 255) {
-      blockCount+=e->count;
-      e++;
-      totalWrite += sizeof(entry_t); 
-      
-      e->type = b.id();
-      ENSURES(e->type <= 4);
-      e->count = 1;
-      ENSURES(totalWrite <= maxWrite);
-    } else {
-      e->count++;
+  // same entries as going block by block, a uniform section is just a long run
+  auto appendRun = [&](block_id_t id, uint count) {
+    while(count > 0) {
+      if(e->count == 0 || e->type != id || e->count == 255) {
+        if(e->count != 0) {
+          blockCount+=e->count;
+          e++;
+          totalWrite += sizeof(entry_t); 
+          ENSURES(totalWrite <= maxWrite);
+        }
+        e->type = id;
+        e->count = 0;
+      }
+      uint n = std::min(count, 255u - e->count);
+      e->count += n;
+      count -= n;
+    }
+  };
+
+  for(uint s = 0; s < kSectionCount; s++) {
+    if(mBlocks.uniform(s)) {
+      appendRun(mBlocks.uniformBlock(s).id(), kSectionBlockCount);
+      continue;
+    }
+    // saves are in linear order whatever the index layout
+    uint begin = s * kSectionBlockCount;
+    for(uint i = begin; i < begin + kSectionBlockCount; i++) {
+      appendRun(mBlocks.id(BlockCoords::fromLinear(i)), 1);
     }
   }
 
@@ -508,26 +643,58 @@ size_t Chunk::serialize(byte_t* data, size_t maxWrite) const {
   }
   ENSURES(totalWrite <= maxWrite && ((totalWrite & 1) == 0));
   ENSURES(blockCount == kTotalBlockCount);
+
+  border_edit_t* b = (border_edit_t*)(data + totalWrite);
+  for(const routed_edit_t& edit: mBorderEdits) {
+    BlockCoords block = BlockCoords::fromIndex(edit.edit.index);
+    chunk_coords_t offset = edit.target - mCoords;
+    b->linear = uint16_t(uint(block.x) | (uint(block.y) << kSizeBitX) | (uint(block.z) << (kSizeBitX + kSizeBitY)));
+    b->offset[0] = int8_t(offset.x);
+    b->offset[1] = int8_t(offset.y);
+#if CUBIC_CHUNKS
+    b->offset[2] = int8_t(offset.z);
+#else
+    b->offset[2] = 0;
+#endif
+    b->id = edit.edit.id;
+    b++;
+    totalWrite += sizeof(border_edit_t);
+  }
+  ENSURES(totalWrite <= maxWrite);
   return totalWrite;
 }
 
-void Chunk::deserialize(byte_t* data, size_t maxRead) {
+bool Chunk::deserialize(byte_t* data, size_t maxRead) {
 
+  if(maxRead < offsetof(chunk_header_t, fedBy)) return false;
+  chunk_header_t header;
+  memcpy(&header, data, std::min(maxRead, sizeof(chunk_header_t)));
   size_t totalRead = sizeof(chunk_header_t);
-  {
-    chunk_header_t* header = (chunk_header_t*)data;
-    ENSURES(*header == chunk_header_t());
+  if(header.version == 1) {
+    // no fed-by bits and no border edits yet, it takes whatever is parked for it as before
+    header.version = chunk_header_t().version;
+    header.fedBy = 0;
+    totalRead = offsetof(chunk_header_t, fedBy);
   }
-  ENSURES(totalRead < maxRead);
-  entry_t* entry = (entry_t*)(data + sizeof(chunk_header_t));
-
-  BlockIndex index = 0;
-  while(totalRead < maxRead) {
-    BlockDef* def = BlockDef::get(entry->type);
-
-    for(BlockIndex i = 0; i < entry->count; i++) {
-      BlockIndex bi = i + index;
-      resetBlock(bi, *def);
+  // saved by a build with other chunk dimensions, format or terrain generator, let it be generated again
+  // rather than leave a seam against its generated neighbors
+  if(totalRead > maxRead || !header.sameLayout(chunk_header_t())) return false;
+  entry_t* entry = (entry_t*)(data + totalRead);
+
+  // runs are unpacked into the whole chunk first, they cross sections freely
+  thread_local std::vector<block_id_t> ids(kTotalBlockCount);
+  thread_local std::vector<uint8_t> staticFlags(kTotalBlockCount);
+
+  uint index = 0;
+  while(index < kTotalBlockCount) {
+    ENSURES(totalRead + sizeof(entry_t) <= maxRead);
+    ENSURES(index + entry->count <= kTotalBlockCount);
+    uint8_t flags = BlockProperties::opaque(entry->type) ? Block::kOpaqueFlag : 0x0;
+
+    for(uint i = index; i < index + entry->count; i++) {
+      BlockIndex m = BlockCoords::fromLinear(i);
+      ids[m] = entry->type;
+      staticFlags[m] = flags;
     }
 
     index += entry->count;
@@ -535,8 +702,32 @@ void Chunk::deserialize(byte_t* data, size_t maxRead) {
     entry++;
   }
 
-  // should be wrap around;
-  ENSURES(index == 0);
+  ENSURES(index == kTotalBlockCount);
+
+  for(uint s = 0; s < kSectionCount; s++) {
+    writeSection(s, &ids[s * kSectionBlockCount], &staticFlags[s * kSectionBlockCount]);
+  }
+  // its trees crown neighbors that may be generated after it was saved, they get them from here
+  mBorderEdits.clear();
+  border_edit_t* b = (border_edit_t*)(data + totalRead);
+  for(; totalRead + sizeof(border_edit_t) <= maxRead; totalRead += sizeof(border_edit_t), b++) {
+#if CUBIC_CHUNKS
+    ChunkCoords target = mCoords + ChunkCoords{ ivec3{ b->offset[0], b->offset[1], b->offset[2] } };
+#else
+    ChunkCoords target = mCoords + ChunkCoords{ b->offset[0], b->offset[1] };
+#endif
+    block_edit_t edit = { BlockCoords::fromLinear(b->linear), b->id, PendingEdits::sourceSlot(target, mCoords) };
+    mBorderEdits.push_back({ target, edit });
+  }
+  PendingEdits& store = PendingEdits::get();
+  store.push(mBorderEdits);
+
+  // whatever the neighbors generated into it while it was saved away, less what it had taken already
+  mFedBy = header.fedBy;
+  std::vector<block_edit_t> pending = takeNewEdits(store);
+  applyEdits(pending);
+  endBulkWrite();
+  return true;
 }
 
 void Chunk::resetBlock(BlockIndex index, BlockDef& def) {
@@ -544,109 +735,130 @@ void Chunk::resetBlock(BlockIndex index, BlockDef& def) {
   iter.reset(def);
 }
 
-void Chunk::addBlock(const BlockIter& block, const vec3& pivot) {
-
-    /*
-     *     2 ----- 1
-     *    /|      /|
-     *   3 ----- 0 |
-     *   | 6 ----|-5
-     *   |/      |/             x  
-     *   7 ----- 4         y___/
-     */  
-    vec3 vertices[8] = {
-      vec3{ 0 + pivot.x, 0 + pivot.y, 1 + pivot.z },
-      vec3{ 1 + pivot.x, 0 + pivot.y, 1 + pivot.z },
-      vec3{ 1 + pivot.x, 1 + pivot.y, 1 + pivot.z },
-      vec3{ 0 + pivot.x, 1 + pivot.y, 1 + pivot.z },
-
-      vec3{ 0 + pivot.x, 0 + pivot.y, 0 + pivot.z },     
-      vec3{ 1 + pivot.x, 0 + pivot.y, 0 + pivot.z },
-      vec3{ 1 + pivot.x, 1 + pivot.y, 0 + pivot.z },
-      vec3{ 0 + pivot.x, 1 + pivot.y, 0 + pivot.z },
-    };
-
-    struct Face {
-      uint v[4];
-    };
-
-    static constexpr Face faces[6] = {
-      {5, 6, 2, 1},
-      {7, 4, 0, 3},
-      {4, 5, 1, 0},
-      {6, 7, 3, 2},
-      {4, 7, 6, 5},
-      {0, 1, 2, 3}
-    };
-
-    static const vec3 normals[6] = {
-      {1, 0, 0},
-      {-1, 0, 0},
-      {0, -1, 0},
-      {0, 1, 0},
-      {0, 0, -1},
-      {0, 0, 1}
-    };
-
-    static const vec3 tangents[6] = {
-      {0, 1, 0},
-      {0, 1, 0},
-      {1, 0, 0},
-      {1, 0, 0},
-      {1, 0, 0},
-      {1, 0, 0}
-    };
-
-    static constexpr BlockDef::eFace uvs[6] = {
-      BlockDef::FACE_SIDE,
-      BlockDef::FACE_SIDE,
-      BlockDef::FACE_SIDE,
-      BlockDef::FACE_SIDE,
-      BlockDef::FACE_BTM,
-      BlockDef::FACE_TOP
-    };
-
-    BlockIter neighbors[6] = {
-      block.nextPosX(),
-      block.nextNegX(),
-      block.nextNegY(),
-      block.nextPosY(),
-      block.nextNegZ(),
-      block.nextPosZ()
-    };
-
-
-    const BlockDef& def = block->type();
-    if(block->id() != 0) {
-      for(uint i = 0; i < 6; i++) {
-        BlockIter neighbor = neighbors[i];
-        if(!neighbor->opaque()) {
-          mMesher.normal(normals[i]);
-          mMesher.tangent(tangents[i]);
-          aabb2 uv = def.uvs(uvs[i]);
-
-          Face face = faces[i];
-
-          Rgba color(neighbor->indoorLight() * 16, neighbor->outdoorLight() * 16, 0);
-          // if(neighbor->indoorLight()) {
-          //   DEBUGBREAK;
-          // }
-          mMesher.color(color);
-
-          mMesher.uv(uv.mins)
-                 .vertex3f(vertices[face.v[0]]);
-          mMesher.uv({uv.maxs.x, uv.mins.y})
-                 .vertex3f(vertices[face.v[1]]);
-          mMesher.uv(uv.maxs)
-                 .vertex3f(vertices[face.v[2]]);
-          mMesher.uv({uv.mins.x, uv.maxs.y})
-                 .vertex3f(vertices[face.v[3]]);
-          mMesher.quad();
-        }
+void Chunk::writeSection(uint section, const block_id_t* ids, const uint8_t* flags) {
+  mBlocks.assign(section, ids, flags);
+
+  BlockIndex base = BlockIndex(section * kSectionBlockCount);
+  int sectionBottom = int(section * kSectionSizeZ);
+  for(int z = sectionBottom; z < sectionBottom + int(kSectionSizeZ); z++) {
+    uint64_t columnBit = 1ull << (z & 63);
+    for(BlockIndex y = 0; y < kSizeY; y++) {
+      row_t clear = 0;
+      for(BlockIndex x = 0; x < kSizeX; x++) {
+        bool opaque = flags[BlockCoords::toIndex(x, y, BlockIndex(z)) - base] & Block::kOpaqueFlag;
+        clear |= opaque ? row_t(0) : row_t(row_t(1) << x);
+
+        uint64_t& word = mClearColumns[x | (y << kSizeBitX)][z >> 6];
+        word = opaque ? (word & ~columnBit) : (word | columnBit);
       }
+      mClearRows[y | (z << kSizeBitY)] = clear;
     }
-    
   }
+}
+
+void Chunk::writeSection(uint section, const BlockDef& def) {
+  mBlocks.fill(section, def.id(), def.opaque() ? Block::kOpaqueFlag : 0x0);
+  setSectionOpacityMasks(section, def.opaque());
+}
+
+void Chunk::endBulkWrite() {
+  rebuildHeightMap();
+  mVolumeDirtySections = kAllSections;
+
+  // chunks generated off the world point at the shared invalid chunk, leave it alone
+  setDirty();
+  for(Chunk* neighbor: mNeighbors) {
+    if(neighbor->valid()) neighbor->setDirty();
+  }
+}
+
+void Chunk::applyEdits(span<const block_edit_t> edits) {
+  for(const block_edit_t& e: edits) {
+    if(opaque(e.index)) continue;
+    bool opaqueBlock = BlockProperties::opaque(e.id);
+    mBlocks.reset(e.index, e.id, opaqueBlock ? Block::kOpaqueFlag : 0x0);
+    setOpaque(e.index, opaqueBlock);
+  }
+}
+
+std::vector<block_edit_t> Chunk::takeNewEdits(PendingEdits& store) {
+  std::vector<block_edit_t> edits = store.take(mCoords);
+  uint32_t fedBy = mFedBy;
+  edits.erase(std::remove_if(edits.begin(), edits.end(), [fedBy](const block_edit_t& e) {
+    return (fedBy >> e.source) & 1u;
+  }), edits.end());
+  for(const block_edit_t& e: edits) {
+    mFedBy |= 1u << e.source;
+  }
+  return edits;
+}
+
+void Chunk::applyLiveEdits(span<const block_edit_t> edits) {
+  for(const block_edit_t& e: edits) {
+    if(opaque(e.index)) continue;
+    BlockIter iter = blockIter(e.index);
+    iter.reset(*BlockDef::get(e.id));
+    iter.dirtyLight();
+  }
+  // not a reason to save it: the writer pushes the same edits whenever it is generated or loaded again,
+  // only player edits are saved
+}
+
+void Chunk::resetSection(uint section, BlockDef& def) {
+  mBlocks.fill(section, def.id(), def.opaque() ? Block::kOpaqueFlag : 0x0);
+  setSectionOpaque(section, def.opaque());
+
+  // a full section touches every side: the sections over and under it, the same section next door
+  uint32_t own = 1u << section;
+  setVolumeDirty(own);
+  setSectionsDirty((own | (own << 1) | (own >> 1)) & kAllSections);
+  for(Chunk* neighbor: mNeighbors) {
+    neighbor->setSectionsDirty(own);
+  }
+}
+
+uint32_t Chunk::sectionsShowing(BlockIndex index) {
+  uint z = uint(BlockCoords::fromIndex(index).z);
+  uint section = z / kSectionSizeZ;
+  uint32_t sections = 1u << section;
+  if(z % kSectionSizeZ == 0 && section > 0) sections |= sections >> 1;
+  if(z % kSectionSizeZ == kSectionSizeZ - 1 && section + 1 < kSectionCount) sections |= sections << 1;
+  return sections;
+}
+
+static constexpr BlockDef::eFace kFaceSprites[6] = {
+  BlockDef::FACE_SIDE,
+  BlockDef::FACE_SIDE,
+  BlockDef::FACE_SIDE,
+  BlockDef::FACE_SIDE,
+  BlockDef::FACE_BTM,
+  BlockDef::FACE_TOP
+};
+
+void Chunk::addQuad(Mesher& mesher, const vec3& pivot, const chunk_quad_t& quad) {
+  uint8_t indoor = quad.light & Block::kIndoorLightMask;
+  uint8_t outdoor = (quad.light & Block::kOutdoorLightMask) >> 4;
+
+#if CHUNK_MESHER_MODE == CHUNK_MESHER_GREEDY
+  uvec2 sprite = BlockDef::spriteIndexToCoords(quad.sprite);
+  Rgba color(uint8_t(indoor * 16), uint8_t(outdoor * 16), uint8_t(sprite.x), uint8_t(sprite.y));
+  float width = float(quad.width), height = float(quad.height);
+  const vec2 uvs[4] = { { 0, 0 }, { width, 0 }, { width, height }, { 0, height } };
+#else
+  Rgba color(indoor * 16, outdoor * 16, 0);
+  aabb2 uv = BlockDef::spriteUVs(quad.sprite);
+  const vec2 uvs[4] = { uv.mins, { uv.maxs.x, uv.mins.y }, uv.maxs, { uv.mins.x, uv.maxs.y } };
+#endif
+
+  mesher.normal(chunk_face_t::normal(quad.face));
+  mesher.tangent(chunk_face_t::tangent(quad.face));
+  mesher.color(color);
+  for(uint c = 0; c < 4; c++) {
+    mesher.uv(uvs[c])
+          .vertex3f(pivot + vec3(quad.corner(c)));
+  }
+  mesher.quad();
+}
 
 void Chunk::markBlockLightDirty(const BlockIter& block) {
   if(block->lightDirty()) return;
@@ -654,90 +866,261 @@ void Chunk::markBlockLightDirty(const BlockIter& block) {
   block->setLightDirty();
 };
 
-void Chunk::generateBlocks() {
-  float noises[kSizeX][kSizeY];
+void Chunk::generateBlocks(uint seed) {
+  PendingEdits& store = PendingEdits::get();
+  generateTerrain(seed, store);
+  std::vector<block_edit_t> pending = takeNewEdits(store);
+  applyEdits(pending);
+  endBulkWrite();
+
+  mState = CHUNK_STATE_LOADED_NO_MESH;
+}
+
+void Chunk::generateTerrain(uint seed, PendingEdits& overflow) {
+  // fresh blocks, nothing of the neighbors in them yet
+  mFedBy = 0;
 
-  constexpr BlockIndex kWorldSeaLevel = 100;
-  constexpr int kChangeRange = (int(kSizeZ) - int(kWorldSeaLevel)) / 3;
+  // surface height of every column relative to the chunk bottom, x fastest
+  float heights[kSizeX * kSizeY];
+
+  constexpr int kWorldSeaLevel = 100;
+  constexpr int kChangeRange = (kTerrainHeight - kWorldSeaLevel) / 3;
+
+  // heights are relative to the bottom of the chunk, a cubic chunk can be all above or all below them
+  float minZMax = std::numeric_limits<float>::max();
+  float maxZMax = std::numeric_limits<float>::lowest();
 
   vec2 base = mCoords.pivotPosition().xy();
-  for(uint i = 0; i < kSizeX; i++) {
-    for(uint j = 0; j < kSizeY; j++) {
-     vec2 worldPosition = vec2((float)i, (float)j) + base;
-      float noise = Compute2dPerlinNoise(worldPosition.x , worldPosition.y, 200, 3);
-      noises[i][j] = float(kChangeRange) * noise + float(kWorldSeaLevel);
-    }
+  float baseZ = mCoords.pivotPosition().z;
+
+  // the whole column grid in one go, bit identical to one Compute2dPerlinNoise per column
+  float surface[kSizeX * kSizeY];
+  Compute2dPerlinNoiseGrid(surface, kSizeX, kSizeY, base, 200, 3, .5f, 2.f, true, TerrainDensity::noiseSeed(seed, 0));
+
+  for(uint i = 0; i < kSizeX * kSizeY; i++) {
+    heights[i] = float(kChangeRange) * surface[i] + float(kWorldSeaLevel) - baseZ;
+    minZMax = std::min(minZMax, heights[i]);
+    maxZMax = std::max(maxZMax, heights[i]);
   }
 
-  BlockDef* air = BlockDef::get("air");
-  BlockDef* dust = BlockDef::get("dust");
-  BlockDef* stone = BlockDef::get("stone");
-  BlockDef* grass = BlockDef::get("grass");
+  // climate comes from the cached coarse region map, a couple of lerps per column
+  float temperature[kSizeX * kSizeY];
+  float humidity[kSizeX * kSizeY];
+  eBiome biomes[kSizeX * kSizeY];
+  ClimateMap::get().sampleColumns(base, seed, temperature, humidity);
+  for(uint i = 0; i < kSizeX * kSizeY; i++) {
+    biomes[i] = ClimateMap::biome(temperature[i], humidity[i]);
+  }
 
-  BlockIndex m = 0;
-  for(int k = 0; k < kSizeZ; k++) {
+  // definitions are loaded once before any chunk, resolve them once as well
+  static BlockDef* const air = BlockDef::get("air");
+  static BlockDef* const stone = BlockDef::get("stone");
+
+  block_id_t ids[kSectionBlockCount];
+  uint8_t staticFlags[kSectionBlockCount];
+
+#if TERRAIN_GENERATOR_MODE == TERRAIN_GENERATOR_DENSITY
+  TerrainDensity density(mCoords.pivotPosition(), heights, biomes, seed);
+
+  for(uint s = 0; s < kSectionCount; s++) {
+    switch(density.classify(s)) {
+      case TerrainDensity::SECTION_AIR:
+        writeSection(s, *air);
+        break;
+      case TerrainDensity::SECTION_STONE:
+        writeSection(s, *stone);
+        break;
+      case TerrainDensity::SECTION_MIXED:
+        density.fillSection(s, ids, staticFlags);
+        writeSection(s, ids, staticFlags);
+        break;
+    }
+  }
+#else
+  for(uint s = 0; s < kSectionCount; s++) {
+    int sectionBottom = int(s * kSectionSizeZ);
+    int sectionTop = sectionBottom + kSectionSizeZ - 1;
+
+    // only the sections crossing the surface band need to go block by block
+    if(float(sectionBottom) > maxZMax) {
+      writeSection(s, *air);
+      continue;
+    }
+    if(float(sectionTop) < minZMax - 3) {
+      writeSection(s, *stone);
+      continue;
+    }
+
+    // each column is four z-runs, stone | filler | top | air. the bounds keep the comparisons of
+    // going block by block: air above the surface, top within 1 below it, filler within 3
+    BlockIndex base = BlockIndex(s * kSectionBlockCount);
     for(int j = 0; j < kSizeY; j++) {
       for(int i = 0; i < kSizeX; i++) {
+        float surfaceZ = heights[i + j * kSizeX];
+        const biome_blocks_t& biomeBlocks = ClimateMap::blocks(biomes[i + j * kSizeX]);
+        int airBegin = (int)floor(surfaceZ) + 1;
+        int grassBegin = (int)ceil(surfaceZ - 1);
+        int dustBegin = (int)ceil(surfaceZ - 3);
+
+        auto run = [&](int begin, int end, const BlockDef* def) {
+          begin = std::max(begin, sectionBottom);
+          end = std::min(end, sectionTop + 1);
+          uint8_t flags = def->opaque() ? Block::kOpaqueFlag : 0x0;
+          for(int k = begin; k < end; k++) {
+            BlockIndex m = BlockCoords::toIndex(BlockIndex(i), BlockIndex(j), BlockIndex(k)) - base;
+            ids[m] = def->id();
+            staticFlags[m] = flags;
+          }
+        };
+        run(sectionBottom, dustBegin, stone);
+        run(dustBegin, grassBegin, biomeBlocks.filler);
+        run(grassBegin, airBegin, biomeBlocks.top);
+        run(airBegin, sectionTop + 1, air);
+      }
+    }
+
+    writeSection(s, ids, staticFlags);
+  }
+#endif
 
-        BlockCoords coords{i, j, k};
+  plantTrees(seed, biomes, overflow);
+}
 
-        float currentZMax = noises[coords.x][coords.y];
+void Chunk::plantTrees(uint seed, const eBiome* biomes, PendingEdits& overflow) {
+  constexpr uint kTreeStream = 6;
+  // about one column in this many grows a tree
+  constexpr uint kTreeChance = 97;
 
-        if(coords.z > currentZMax) {
-          resetBlock(m, *air);
-        } else if(coords.z >= currentZMax - 1) {
-          resetBlock(m, *grass);
-        } else if(coords.z >= currentZMax - 3) {
-         resetBlock(m, *dust);
-        } else {
-         resetBlock(m, *stone);
-        }
+  static BlockDef* const wood = BlockDef::get("wood");
+  static BlockDef* const leaves = BlockDef::get("leaves");
+
+  // the ground of what was just written, the density stage moves it off the 2d surface
+  rebuildHeightMap();
+
+  ivec3 pivot = ivec3(mCoords.pivotPosition());
+  std::vector<routed_edit_t> outside;
+
+  auto place = [&](int x, int y, int z, const BlockDef& def) {
+    bool inside = x >= 0 && x < int(kSizeX) && y >= 0 && y < int(kSizeY) && z >= 0 && z < int(kSizeZ);
+    if(inside) {
+      block_edit_t edit = { BlockCoords::toIndex(BlockIndex(x), BlockIndex(y), BlockIndex(z)), def.id() };
+      applyEdits({ &edit, 1 });
+      return;
+    }
+
+    ivec3 world = pivot + ivec3{ x, y, z };
+#if CUBIC_CHUNKS
+    ChunkCoords target = ivec3{ world.x >> kSizeBitX, world.y >> kSizeBitY, world.z >> kSizeBitZ };
+#else
+    if(world.z < 0 || world.z >= int(kSizeZ)) return;
+    ChunkCoords target = { world.x >> kSizeBitX, world.y >> kSizeBitY };
+#endif
+    ivec3 local = world - ivec3(target.pivotPosition());
+    BlockIndex index = BlockCoords::toIndex(BlockIndex(local.x), BlockIndex(local.y), BlockIndex(local.z));
+    outside.push_back({ target, { index, def.id(), PendingEdits::sourceSlot(target, mCoords) } });
+  };
 
-        m++;
+  for(int j = 0; j < int(kSizeY); j++) {
+    for(int i = 0; i < int(kSizeX); i++) {
+      uint column = uint(i) | (uint(j) << kSizeBitX);
+      if(biomes[column] != BIOME_TEMPERATE) continue;
 
+      uint hash = Get2dNoiseUint(pivot.x + i, pivot.y + j, TerrainDensity::noiseSeed(seed, kTreeStream));
+      if(hash % kTreeChance != 0) continue;
+
+      int ground = int(mHeightMap[column]) - 1;
+      if(ground < 0) continue;
+      BlockIndex groundIndex = BlockCoords::toIndex(BlockIndex(i), BlockIndex(j), BlockIndex(ground));
+      if(mBlocks.id(groundIndex) != ClimateMap::blocks(BIOME_TEMPERATE).top->id()) continue;
+
+      int trunk = 4 + int((hash >> 8) % 3);
+      for(int k = 1; k <= trunk; k++) {
+        place(i, j, ground + k, *wood);
+      }
+
+      // two wide layers around the trunk top, two narrow ones over it, corners left out
+      for(int k = trunk - 1; k <= trunk + 2; k++) {
+        int radius = k < trunk + 1 ? 2 : 1;
+        for(int dy = -radius; dy <= radius; dy++) {
+          for(int dx = -radius; dx <= radius; dx++) {
+            if(std::abs(dx) == radius && std::abs(dy) == radius) continue;
+            place(i + dx, j + dy, ground + k, *leaves);
+          }
+        }
       }
     }
   }
 
-  mState = CHUNK_STATE_LOADED_NO_MESH;
+  overflow.push(outside);
+  mBorderEdits = std::move(outside);
 }
 
 void Chunk::initLights() {
+  mVolumeDirtySections = kAllSections;
+
+  bool openSky = true;
+  for(BlockIndex y = 0; y < kSizeY && openSky; y++) {
+    for(BlockIndex x = 0; x < kSizeX && openSky; x++) {
+      openSky = skyAbove(x, y);
+    }
+  }
+
+  // see-through uniform sections on top of the column are all sky, light them as a whole
+  uint skySections = 0;
+  for(int s = kSectionCount - 1; s >= 0 && openSky; s--) {
+    if(!mBlocks.uniform(s) || mBlocks.uniformBlock(s).opaque()) break;
+    Block sky = mBlocks.uniformBlock(s);
+    sky.setSky();
+    mBlocks.fillLight(s, sky.light());
+    skySections++;
+  }
+  int skyBottom = int(kSizeZ) - int(skySections * kSectionSizeZ);
   
   // populate outdoor lighting
-  for(BlockIndex y = 0; y < kSizeY; y++) {
-    for(BlockIndex x = 0; x < kSizeX; x++) {
-      BlockIndex index = BlockCoords::toIndex(x, y, kSizeZ - 1);
-      BlockIter iter = blockIter(index);
-      while(!iter->opaque() && iter.valid()) {
-        iter->setSky();
-        iter.stepNegZ();
+  if(skyBottom > 0) {
+    for(BlockIndex y = 0; y < kSizeY; y++) {
+      for(BlockIndex x = 0; x < kSizeX; x++) {
+        if(!skyAbove(x, y)) continue;
+        for(int z = height(x, y); z < skyBottom; z++) {
+          block(BlockCoords::toIndex(x, y, BlockIndex(z))).setSky();
+        }
       }
     }
   }
 
+  // sky flags are final from here, walk the lit columns on a padded copy.
+  // the apron reads unloaded neighbors as invalid, which is opaque and skipped like before
+  thread_local PaddedChunk blocks;
+  blocks.gather(*ChunkSnapshot::capture(*this));
+
+  static const BlockCoords sideSteps[4] = {
+    {-1,  0,  0},
+    { 1,  0,  0},
+    { 0, -1,  0},
+    { 0,  1,  0},
+  };
+  static constexpr int sideOffsets[4] = { -1, 1, -PaddedChunk::kStrideY, PaddedChunk::kStrideY };
+
   for(BlockIndex y = 0; y < kSizeY; y++) {
     for(BlockIndex x = 0; x < kSizeX; x++) {
-      BlockIndex index = BlockCoords::toIndex(x, y, kSizeZ - 1);
-      BlockIter iter = blockIter(index);
-      while(!iter->opaque() && iter.valid()) {
-        EXPECTS(iter->exposedToSky());
-
-        BlockIter neighbors[4] = {
-          iter.nextNegX(),
-          iter.nextPosX(),
-          iter.nextNegY(),
-          iter.nextPosY(),
-        };
-
-        for(BlockIter& neighbor: neighbors) {
-          if(neighbor->exposedToSky()) continue;
-          if(!neighbor.valid()) continue;
-          if(neighbor->opaque()) continue;
-          markBlockLightDirty(neighbor);
+      if(!skyAbove(x, y)) continue;
+      // inside the sky sections, only the columns on the chunk border can see a block without sky
+      bool border = x == 0 || x == kSizeX - 1 || y == 0 || y == kSizeY - 1;
+      int top = border ? kSizeZ - 1 : skyBottom - 1;
+      if(top < 0) continue;
+
+      int index = PaddedChunk::index(x, y, top);
+      // stays in this chunk, cubic chunks would step into the one below
+      for(int z = top; z >= 0 && !blocks[index].opaque(); z--, index -= PaddedChunk::kStrideZ) {
+        EXPECTS(blocks[index].exposedToSky());
+
+        for(uint i = 0; i < 4; i++) {
+          const Block& neighbor = blocks[index + sideOffsets[i]];
+          if(neighbor.exposedToSky()) continue;
+          if(neighbor.opaque()) continue;
+          // rare, only now pay for the iterator
+          markBlockLightDirty(blockIter(BlockCoords::toIndex(x, y, BlockIndex(z))).next(sideSteps[i]));
         }
-
-        iter.stepNegZ();
       }
     }
   }
@@ -752,71 +1135,224 @@ void Chunk::initLights() {
    *        └──┘
    *         -x
    */
+  markBoundaryLightDirty(NEIGHBOR_POS_X);
+  markBoundaryLightDirty(NEIGHBOR_NEG_X);
+  markBoundaryLightDirty(NEIGHBOR_POS_Y);
+  markBoundaryLightDirty(NEIGHBOR_NEG_Y);
+
+#if CUBIC_CHUNKS
+  // the chunk below took the sky for granted while this one was not there, and the one on top
+  // may have been waiting for light from here
+  markBoundaryLightDirty(NEIGHBOR_POS_Z);
+  markBoundaryLightDirty(NEIGHBOR_NEG_Z);
+  mNeighbors[NEIGHBOR_NEG_Z]->markBoundaryLightDirty(NEIGHBOR_POS_Z);
+  mNeighbors[NEIGHBOR_POS_Z]->markBoundaryLightDirty(NEIGHBOR_NEG_Z);
+#endif
+
+  for(uint s = 0; s < kSectionCount; s++) {
+    uint begin = s * kSectionBlockCount;
+    if(mBlocks.uniform(s) && !BlockProperties::emitter(mBlocks.uniformBlock(s).id())) continue;
+
+    for(uint i = begin; i < begin + kSectionBlockCount; i++) {
+      // light source
+      if(BlockProperties::emitter(mBlocks.id(i))) {
+        markBlockLightDirty({ *this, (BlockIndex)i});
+      } 
+    }
+  }
 
-  // +x
-  if(neighbor(NEIGHBOR_POS_X).valid()) {
-    uint16_t x = kSizeMaskX;
-    for(uint16_t z = 0; z < kSizeZ; z++) {
-      for(uint16_t y = 0; y < kSizeY; y++) {
-        BlockIndex index = BlockCoords::toIndex(x, y, z);
-        BlockIter iter = blockIter(index);
-        if(!iter->opaque()) {
+}
+
+bool Chunk::skyAbove(BlockIndex x, BlockIndex y) const {
+#if CUBIC_CHUNKS
+  const Chunk* above = mNeighbors[NEIGHBOR_POS_Z];
+  return !above->valid() || above->block(BlockCoords::toIndex(x, y, 0)).exposedToSky();
+#else
+  (void)x; (void)y;
+  return true;
+#endif
+}
+
+void Chunk::markBoundaryLightDirty(eNeighbor side) {
+  const Chunk* other = mNeighbors[side];
+  if(!other->valid()) return;
+
+#if CUBIC_CHUNKS
+  if(side == NEIGHBOR_POS_Z || side == NEIGHBOR_NEG_Z) {
+    BlockIndex z = side == NEIGHBOR_POS_Z ? kSizeZ - 1 : 0;
+    for(BlockIndex y = 0; y < kSizeY; y++) {
+      for(BlockIndex x = 0; x < kSizeX; x++) {
+        BlockIter iter = blockIter(BlockCoords::toIndex(x, y, z));
+        if(!iter.opaque()) {
           markBlockLightDirty(iter);
         }
       }
     }
+    return;
   }
-  
-  // -x
-  if(neighbor(NEIGHBOR_NEG_X).valid()) {
-    uint16_t x = 0;
-    for(uint16_t z = 0; z < kSizeZ; z++) {
-      for(uint16_t y = 0; y < kSizeY; y++) {
-        BlockIndex index = BlockCoords::toIndex(x, y, z);
-        BlockIter iter = blockIter(index);
-        if(!iter->opaque()) {
-          markBlockLightDirty(iter);
-        }
+#endif
+
+  for(uint s = 0; s < kSectionCount; s++) {
+    // nothing new can flow in between two uniform sections holding the same light, or into an opaque one
+    if(mBlocks.uniform(s)) {
+      const Block& mine = mBlocks.uniformBlock(s);
+      if(mine.opaque()) continue;
+      if(other->mBlocks.uniform(s)) {
+        const Block& theirs = other->mBlocks.uniformBlock(s);
+        if(theirs.opaque() || theirs.light() == mine.light()) continue;
       }
     }
-  }
-  
-  // +y
-  if(neighbor(NEIGHBOR_POS_Y).valid()) {
-    uint16_t y = kSizeMaskY;
-    for(uint16_t z = 0; z < kSizeZ; z++) {
-      for(uint16_t x = 0; x < kSizeX; x++) {
-        BlockIndex index = BlockCoords::toIndex(x, y, z);
+
+    uint16_t sideLength = (side == NEIGHBOR_POS_X || side == NEIGHBOR_NEG_X) ? kSizeY : kSizeX;
+    for(uint16_t z = uint16_t(s * kSectionSizeZ); z < (s + 1) * kSectionSizeZ; z++) {
+      for(uint16_t t = 0; t < sideLength; t++) {
+        BlockIndex index = 0;
+        switch(side) {
+          case NEIGHBOR_POS_X: index = BlockCoords::toIndex(kSizeX - 1, t, z); break;
+          case NEIGHBOR_NEG_X: index = BlockCoords::toIndex(0, t, z); break;
+          case NEIGHBOR_POS_Y: index = BlockCoords::toIndex(t, kSizeY - 1, z); break;
+          case NEIGHBOR_NEG_Y: index = BlockCoords::toIndex(t, 0, z); break;
+          default: ;
+        }
         BlockIter iter = blockIter(index);
-        if(!iter->opaque()) {
+        if(!iter.opaque()) {
           markBlockLightDirty(iter);
         }
       }
     }
   }
-  
-  // -y
-  if(neighbor(NEIGHBOR_NEG_Y).valid()) {
-    uint16_t y = 0;
-    for(uint16_t z = 0; z < kSizeZ; z++) {
-      for(uint16_t x = 0; x < kSizeX; x++) {
-        BlockIndex index = BlockCoords::toIndex(x, y, z);
-        BlockIter iter = blockIter(index);
-        if(!iter->opaque()) {
-          markBlockLightDirty(iter);
-        }
+}
+
+void Chunk::setOpaque(BlockIndex index, bool opaque) {
+  BlockCoords coords = BlockCoords::fromIndex(index);
+
+  row_t& row = mClearRows[coords.y | (coords.z << kSizeBitY)];
+  row_t rowBit = row_t(row_t(1) << coords.x);
+  row = opaque ? (row & ~rowBit) : (row | rowBit);
+
+  uint column = coords.x | (coords.y << kSizeBitX);
+  uint64_t& word = mClearColumns[column][coords.z >> 6];
+  uint64_t columnBit = 1ull << (coords.z & 63);
+  word = opaque ? (word & ~columnBit) : (word | columnBit);
+
+  // only the top block of a column can move the height, going down rescans below it
+  uint16_t height = mHeightMap[column];
+  if(opaque && coords.z >= height) {
+    setColumnHeight(column, uint16_t(coords.z + 1));
+  } else if(!opaque && coords.z + 1 == height) {
+    setColumnHeight(column, uint16_t(highestOpaque(BlockIndex(coords.x), BlockIndex(coords.y), coords.z) + 1));
+  }
+}
+
+void Chunk::setColumnHeight(uint column, uint16_t height) {
+  uint16_t old = mHeightMap[column];
+  mHeightMap[column] = height;
+
+  if(height >= mMaxHeight) {
+    mMaxHeight = height;
+  } else if(old == mMaxHeight) {
+    mMaxHeight = *std::max_element(mHeightMap.begin(), mHeightMap.end());
+  }
+}
+
+void Chunk::rebuildHeightMap() {
+  for(BlockIndex y = 0; y < kSizeY; y++) {
+    for(BlockIndex x = 0; x < kSizeX; x++) {
+      mHeightMap[x | (y << kSizeBitX)] = uint16_t(highestOpaque(x, y, kSizeZ) + 1);
+    }
+  }
+  mMaxHeight = *std::max_element(mHeightMap.begin(), mHeightMap.end());
+}
+
+aabb3 Chunk::terrainBounds() const {
+  aabb3 bounds = mBounds;
+  bounds.maxs.z = bounds.mins.z + float(mMaxHeight);
+  return bounds;
+}
+
+void Chunk::setSectionOpaque(uint section, bool opaque) {
+  setSectionOpacityMasks(section, opaque);
+
+  int sectionBottom = int(section * kSectionSizeZ);
+  int sectionTop = sectionBottom + kSectionSizeZ;
+  for(BlockIndex y = 0; y < kSizeY; y++) {
+    for(BlockIndex x = 0; x < kSizeX; x++) {
+      uint column = x | (y << kSizeBitX);
+      uint16_t height = mHeightMap[column];
+      if(opaque && height < sectionTop) {
+        setColumnHeight(column, uint16_t(sectionTop));
+      } else if(!opaque && height > sectionBottom && height <= sectionTop) {
+        setColumnHeight(column, uint16_t(highestOpaque(x, y, sectionBottom) + 1));
       }
     }
   }
+}
 
-  for(uint i = 0; i < kTotalBlockCount; i++) {
-    Block& b = mBlocks[i];
-    // light source
-    if(b.type().emissive() > 0) {
-      markBlockLightDirty({ *this, (BlockIndex)i});
-    } 
+void Chunk::setSectionOpacityMasks(uint section, bool opaque) {
+  int sectionBottom = int(section * kSectionSizeZ);
+
+  row_t rowValue = opaque ? 0 : Layout::kRowMask;
+  for(int z = sectionBottom; z < sectionBottom + kSectionSizeZ; z++) {
+    for(int y = 0; y < kSizeY; y++) {
+      mClearRows[y | (z << kSizeBitY)] = rowValue;
+    }
   }
 
+  // a section never straddles two column words
+  uint64_t sectionBits = ((1ull << kSectionSizeZ) - 1ull) << (sectionBottom & 63);
+  for(std::array<uint64_t, kColumnWordCount>& column: mClearColumns) {
+    uint64_t& word = column[sectionBottom >> 6];
+    word = opaque ? (word & ~sectionBits) : (word | sectionBits);
+  }
+}
+
+Chunk::row_t Chunk::opaqueRow(int y, int z) const {
+#if CUBIC_CHUNKS
+  if(z < 0) return mNeighbors[NEIGHBOR_NEG_Z]->opaqueRow(y, z + kSizeZ);
+  if(z >= kSizeZ) return mNeighbors[NEIGHBOR_POS_Z]->opaqueRow(y, z - kSizeZ);
+#else
+  if(z < 0 || z >= kSizeZ) return row_t(~row_t(0));
+#endif
+  if(y < 0) return mNeighbors[NEIGHBOR_NEG_Y]->opaqueRow(y + kSizeY, z);
+  if(y >= kSizeY) return mNeighbors[NEIGHBOR_POS_Y]->opaqueRow(y - kSizeY, z);
+  return row_t(~mClearRows[y | (z << kSizeBitY)]);
+}
+
+Chunk::row_ext_t Chunk::opaqueRowExtended(int y, int z) const {
+  if(y < 0) return mNeighbors[NEIGHBOR_NEG_Y]->opaqueRowExtended(y + kSizeY, z);
+  if(y >= kSizeY) return mNeighbors[NEIGHBOR_POS_Y]->opaqueRowExtended(y - kSizeY, z);
+
+  row_ext_t row = row_ext_t(opaqueRow(y, z) & Layout::kRowMask) << 1;
+  row |= (row_ext_t(mNeighbors[NEIGHBOR_NEG_X]->opaqueRow(y, z)) >> (kSizeX - 1)) & 1u;
+  row |= (row_ext_t(mNeighbors[NEIGHBOR_POS_X]->opaqueRow(y, z)) & 1u) << (kSizeX + 1);
+  return row;
+}
+
+int Chunk::highestOpaque(BlockIndex x, BlockIndex y, int belowZ) const {
+  const std::array<uint64_t, kColumnWordCount>& column = mClearColumns[x | (y << kSizeBitX)];
+  for(int z = belowZ - 1; z >= 0; z = (z & ~63) - 1) {
+    // bits [0, z] of the word holding z
+    uint64_t opaqueBits = ~column[z >> 6] & (~0ull >> (63 - (z & 63)));
+    if(opaqueBits == 0) continue;
+
+    int bit = z & 63;
+    while(((opaqueBits >> bit) & 1ull) == 0) bit--;
+    return (z & ~63) + bit;
+  }
+  return -1;
+}
+
+uint32_t Chunk::opaqueNeighborhood(const BlockIter& center) {
+  BlockCoords coords = center.coords();
+
+  uint32_t mask = 0;
+  for(int dz = -1; dz <= 1; dz++) {
+    for(int dy = -1; dy <= 1; dy++) {
+      row_ext_t row = center.chunk->opaqueRowExtended(coords.y + dy, coords.z + dz);
+      mask |= uint32_t((row >> coords.x) & 0x7u) << ((dy + 1) * 3 + (dz + 1) * 9);
+    }
+  }
+  return mask;
 }
 
 bool Chunk::neighborsLoaded() const {
@@ -826,56 +1362,250 @@ bool Chunk::neighborsLoaded() const {
 }
 
 void Chunk::rebuildGpuMetaData() {
+  // a remesh for a neighbor's edit or for light next door leaves the volume as it is
+  uint32_t sections = mChunkGPUData == nullptr ? kAllSections : mVolumeDirtySections;
+  if(sections == 0) return;
+  mVolumeDirtySections = 0;
+
+  // the blocks are unpacked into the gpu layout first, the scratch keeps the sections that did not change
+#if BLOCK_INDEX_MODE == BLOCK_INDEX_MORTON
+  // the volume texture is linear, a section is a run of it all the same
+  if(mGpuScratch.size() != kTotalBlockCount) {
+    mGpuScratch.resize(kTotalBlockCount);
+    sections = kAllSections;
+  }
+  for(uint s = 0; s < kSectionCount; s++) {
+    if((sections & (1u << s)) == 0) continue;
+    for(uint i = s * kSectionBlockCount; i < (s + 1) * kSectionBlockCount; i++) {
+      mGpuScratch[i] = mBlocks.get(BlockCoords::fromLinear(i));
+    }
+  }
+  Block* gpuBlocks = mGpuScratch.data();
+#else
+  Block* gpuBlocks = mBlocks.gpuData(mGpuScratch, sections);
+#endif
+  // Texture3 has no partial upload, the whole volume goes up again
   mChunkGPUData = Texture3::create(kSizeX, kSizeY, kSizeZ, TEXTURE_FORMAT_R32_UINT, 
-	                RHIResource::BindingFlag::ShaderResource | RHIResource::BindingFlag::UnorderedAccess, mBlocks.data());
+	                RHIResource::BindingFlag::ShaderResource | RHIResource::BindingFlag::UnorderedAccess, gpuBlocks);
   setName(*mChunkGPUData, make_wstring(Stringf("C(%d, %d)", mCoords.x, mCoords.y)).c_str());
 }
 
-bool Chunk::reconstructMesh() {
-  EXPECTS(mIsDirty);
+// index of the lowest set bit, a de Bruijn multiply so it is the same on every platform the project builds for
+static uint lowestBit(uint64_t bits) {
+  static constexpr uint8_t kDeBruijnIndex[64] = {
+     0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4, 
+    62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5, 
+    63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11, 
+    46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6,
+  };
+  return kDeBruijnIndex[((bits & (0ull - bits)) * 0x03f79d71b4cb0a89ull) >> 58];
+}
 
-  if(!neighborsLoaded()) return false;
-  SAFE_DELETE(mMesh);
+// faces of layer z that get a quad, in `chunk_face_t` order and `ChunkSnapshot::layer_t` layout.
+// a face shows where the block is not air and the block on that side is not opaque.
+// opaque blocks are never air, so only the rows that have clear blocks look at the block ids
+static void visibleFaceLayer(const ChunkSnapshot& snapshot, const PaddedChunk& blocks, int z, ChunkSnapshot::layer_t faces[6]) {
+  using layer_t = ChunkSnapshot::layer_t;
+  constexpr uint kRowsPerWord = ChunkSnapshot::kLayerRowsPerWord;
+
+  snapshot.exposedFaces(z, faces);
+
+  layer_t solid = snapshot.opaqueLayer(z);
+  for(uint y = 0; y < Chunk::kSizeY; y++) {
+    uint shift = (y % kRowsPerWord) * Chunk::kSizeX;
+    uint64_t& word = solid[y / kRowsPerWord];
+    if(((word >> shift) & Chunk::Layout::kRowMask) == Chunk::Layout::kRowMask) continue;
+
+    const Block* row = &blocks[PaddedChunk::index(0, int(y), z)];
+    uint64_t present = 0;
+    for(uint x = 0; x < Chunk::kSizeX; x++) {
+      present |= uint64_t(row[x].id() != 0) << x;
+    }
+    word |= present << shift;
+  }
 
-  // mMesher.clear();
-  // mMesher.setWindingOrder(WIND_CLOCKWISE);
-  // mMesher.begin(DRAW_TRIANGES);
-  // mMesher.quad(mCoords.pivotPosition(), {1, 0, 0}, {0, 1, 0}, vec2{float(kSizeX), float(kSizeY)} * .8f);
-  // mMesher.end();
-  // mMesh = mMesher.createMesh<vertex_lit_t>();
-  // mIsDirty = false;
-  // return true;
+  for(uint f = 0; f < 6; f++) {
+    for(uint w = 0; w < ChunkSnapshot::kLayerWordCount; w++) {
+      faces[f][w] &= solid[w];
+    }
+  }
+}
 
-  
-  mMesher.reserve(kSizeX * kSizeY * 3);
-  mMesher.clear();
-  mMesher.setWindingOrder(WIND_CLOCKWISE);
-  mMesher.begin(DRAW_TRIANGES);
+void Chunk::constructCPUMesh(const ChunkSnapshot& snapshot, uint32_t sections, section_meshers_t& meshers) {
+  // one per meshing thread, too big to gather on the stack
+  thread_local PaddedChunk blocks;
+  thread_local std::vector<chunk_quad_t> quads;
+  blocks.gather(snapshot, sections);
+  vec3 pivot = snapshot.coords().pivotPosition();
+
+  for(uint s = 0; s < kSectionCount; s++) {
+    meshers[s] = nullptr;
+    if((sections & (1u << s)) == 0) continue;
+
+    quads.clear();
+    if(!snapshot.sectionHidden(s)) collectQuads(snapshot, blocks, s, quads);
+    if(quads.empty()) continue;
+
+    Mesher* mesher = MesherPool::get().acquire();
+    mesher->clear();
+    mesher->setWindingOrder(WIND_CLOCKWISE);
+    mesher->begin(DRAW_TRIANGES);
+    for(const chunk_quad_t& quad: quads) {
+      addQuad(*mesher, pivot, quad);
+    }
+    mesher->end();
+    meshers[s] = mesher;
+  }
+}
 
+void Chunk::constructGPUMesh(uint32_t sections, section_meshers_t& meshers) {
+  for(uint s = 0; s < kSectionCount; s++) {
+    if((sections & (1u << s)) == 0) continue;
 
-  constexpr BlockIndex kWorldSeaLevel = 100;
-  constexpr int kChangeRange = (int(kSizeZ) - int(kWorldSeaLevel)) / 2;
+    // the old mesh can still be drawn until here
+    SAFE_DELETE(mSectionMeshes[s]);
+    if(meshers[s] != nullptr) {
+      mSectionMeshes[s] = meshers[s]->createMesh<vertex_lit_t>();
+    }
+  }
+  releaseMeshers(meshers);
+  mMeshed = true;
+  rebuildGpuMetaData();
+}
 
-  for(int k = 0; k < kSizeZ; k++) {
-    for(int j = 0; j < kSizeY; j++) {
-      for(int i = 0; i < kSizeX; i++) {
+void Chunk::releaseMeshers(section_meshers_t& meshers) {
+  for(Mesher*& mesher: meshers) {
+    MesherPool::get().release(mesher);
+    mesher = nullptr;
+  }
+}
 
-        BlockCoords coords1{i, j, k};
-        vec3 worldPosition1 = vec3(coords1) + mCoords.pivotPosition();
+void Chunk::collectQuads(const ChunkSnapshot& snapshot, const PaddedChunk& blocks, uint section, std::vector<chunk_quad_t>& quads) {
+#if CHUNK_MESHER_MODE == CHUNK_MESHER_GREEDY
+  collectGreedyQuads(snapshot, blocks, section, quads);
+#else
+  collectFaceQuads(snapshot, blocks, section, quads);
+#endif
+}
 
-        BlockIter iter1 = blockIter(coords1);
-        addBlock(iter1, worldPosition1);
+void Chunk::collectFaceQuads(const ChunkSnapshot& snapshot, const PaddedChunk& blocks, uint section, std::vector<chunk_quad_t>& quads) {
+  for(int k = int(section * kSectionSizeZ); k < int((section + 1) * kSectionSizeZ); k++) {
+    ChunkSnapshot::layer_t faces[6];
+    visibleFaceLayer(snapshot, blocks, k, faces);
+
+    // only the blocks with a face left are visited
+    for(uint w = 0; w < ChunkSnapshot::kLayerWordCount; w++) {
+      uint64_t anyFace = faces[0][w] | faces[1][w] | faces[2][w] | faces[3][w] | faces[4][w] | faces[5][w];
+      for(; anyFace != 0; anyFace &= anyFace - 1) {
+        uint bit = lowestBit(anyFace);
+        int i = int(bit % kSizeX), j = int(w * ChunkSnapshot::kLayerRowsPerWord + bit / kSizeX);
+        int index = PaddedChunk::index(i, j, k);
+        const BlockDef& def = blocks[index].type();
+
+        for(uint f = 0; f < 6; f++) {
+          if(((faces[f][w] >> bit) & 1u) == 0) continue;
+          const Block& neighbor = blocks[index + PaddedChunk::kFaceOffsets[f]];
+          quads.push_back({ uint16_t(i), uint16_t(j), uint16_t(k), uint8_t(f), 1, 1, 
+                            neighbor.light(), uint16_t(def.spriteIndex(kFaceSprites[f])) });
+        }
       }
     }
   }
+}
 
-  mMesher.end();
+void Chunk::collectGreedyQuads(const ChunkSnapshot& snapshot, const PaddedChunk& blocks, uint section, std::vector<chunk_quad_t>& quads) {
+  static_assert(SPRITESHEET_UNIT_COUNT_X == int(BlockDef::kSpritesheetUnitCountX) && 
+                SPRITESHEET_UNIT_COUNT_Y == int(BlockDef::kSpritesheetUnitCountY), "the shader wraps on the same atlas grid");
+
+  // merging stays inside a section, a face key per block of it and face direction, 0 where nothing shows.
+  // faces with the same key look the same: sprite, and the light of the block in front
+  constexpr int kDims[3] = { int(kSizeX), int(kSizeY), int(kSectionSizeZ) };
+  constexpr int kStride[3] = { 1, int(kSizeX), int(kSizeX * kSizeY) };
+  thread_local std::vector<uint32_t> keys(size_t(6) * kSectionBlockCount);
+
+  int sectionBottom = int(section * kSectionSizeZ);
+
+  std::fill(keys.begin(), keys.end(), 0u);
+  bool anyFace = false;
+  for(int k = 0; k < kDims[2]; k++) {
+    ChunkSnapshot::layer_t faces[6];
+    visibleFaceLayer(snapshot, blocks, sectionBottom + k, faces);
+
+    for(uint w = 0; w < ChunkSnapshot::kLayerWordCount; w++) {
+      uint64_t blockFaces = faces[0][w] | faces[1][w] | faces[2][w] | faces[3][w] | faces[4][w] | faces[5][w];
+      for(; blockFaces != 0; blockFaces &= blockFaces - 1) {
+        uint bit = lowestBit(blockFaces);
+        int i = int(bit % kSizeX), j = int(w * ChunkSnapshot::kLayerRowsPerWord + bit / kSizeX);
+        int index = PaddedChunk::index(i, j, sectionBottom + k);
+        const BlockDef& def = blocks[index].type();
+
+        for(uint f = 0; f < 6; f++) {
+          if(((faces[f][w] >> bit) & 1u) == 0) continue;
+          const Block& neighbor = blocks[index + PaddedChunk::kFaceOffsets[f]];
+          uint32_t key = def.spriteIndex(kFaceSprites[f]) | (uint32_t(neighbor.light()) << 16);
+          keys[f * kSectionBlockCount + i * kStride[0] + j * kStride[1] + k * kStride[2]] = key + 1;
+          anyFace = true;
+        }
+      }
+    }
+  }
+  if(!anyFace) return;
+
+  // grow each face into the widest run along u, then as many rows of that run along v as match
+  for(uint f = 0; f < 6; f++) {
+    uint32_t* faceKeys = &keys[f * kSectionBlockCount];
+    uint axisN = chunk_face_t::kNormalAxis[f], axisU = chunk_face_t::kAxisU[f], axisV = chunk_face_t::kAxisV[f];
+
+    for(int n = 0; n < kDims[axisN]; n++) {
+      for(int v = 0; v < kDims[axisV]; v++) {
+        for(int u = 0; u < kDims[axisU]; u++) {
+          int origin = n * kStride[axisN] + u * kStride[axisU] + v * kStride[axisV];
+          uint32_t key = faceKeys[origin];
+          if(key == 0) continue;
+
+          int width = 1;
+          while(u + width < kDims[axisU] && faceKeys[origin + width * kStride[axisU]] == key) width++;
+
+          int height = 1;
+          for(; v + height < kDims[axisV]; height++) {
+            int row = origin + height * kStride[axisV];
+            bool match = true;
+            for(int w = 0; w < width && match; w++) match = faceKeys[row + w * kStride[axisU]] == key;
+            if(!match) break;
+          }
+
+          for(int h = 0; h < height; h++) {
+            for(int w = 0; w < width; w++) {
+              faceKeys[origin + h * kStride[axisV] + w * kStride[axisU]] = 0;
+            }
+          }
+
+          int mins[3];
+          mins[axisN] = n; mins[axisU] = u; mins[axisV] = v;
+          uint32_t look = key - 1;
+          quads.push_back({ uint16_t(mins[0]), uint16_t(mins[1]), uint16_t(mins[2] + sectionBottom), uint8_t(f), 
+                            uint8_t(width), uint8_t(height), uint8_t(look >> 16), uint16_t(look & 0xffff) });
+        }
+      }
+    }
+  }
+}
 
-  mMesh = mMesher.createMesh<vertex_lit_t>();
+bool Chunk::reconstructMesh() {
+  EXPECTS(isDirty());
 
-  rebuildGpuMetaData();
+  if(!neighborsLoaded()) return false;
+
+  // a job in flight would bring older blocks for its sections, build those here too and let it drop its result
+  uint32_t sections = mDirtySections | mMeshingSections;
+  mDirtySections = 0;
+  mMeshingSections = 0;
+  mMeshGeneration++;
 
-  mIsDirty = false;
+  section_meshers_t meshers;
+  constructCPUMesh(*ChunkSnapshot::capture(*this), sections, meshers);
+  constructGPUMesh(sections, meshers);
+  mState = CHUNK_STATE_READY;
 
   return true;
 }
@@ -883,43 +1613,34 @@ bool Chunk::reconstructMesh() {
 S<Job::Counter> Chunk::reconstructMeshAsync() {
   if(!neighborsLoaded()) return nullptr;
   mState = CHUNK_STATE_MESH_CONSTRUCTING;
-  Job::Decl constructCPUMesh([this] {
-    EXPECTS(mIsDirty);
-    SAFE_DELETE(mMesh);
-    
-    mMesher.reserve(kSizeX * kSizeY * 3);
-    mMesher.clear();
-    mMesher.setWindingOrder(WIND_CLOCKWISE);
-    mMesher.begin(DRAW_TRIANGES);
-
-
-    constexpr BlockIndex kWorldSeaLevel = 100;
-    constexpr int kChangeRange = (int(kSizeZ) - int(kWorldSeaLevel)) / 2;
 
-    for(int k = 0; k < kSizeZ; k++) {
-      for(int j = 0; j < kSizeY; j++) {
-        for(int i = 0; i < kSizeX; i++) {
-
-          BlockCoords coords1{i, j, k};
-          vec3 worldPosition1 = vec3(coords1) + mCoords.pivotPosition();
-
-          BlockIter iter1 = blockIter(coords1);
-          addBlock(iter1, worldPosition1);
-        }
+  // the job only reads the snapshot, edits made meanwhile go to fresh copies of the sections
+  // and mark their sections dirty again
+  S<const ChunkSnapshot> snapshot = ChunkSnapshot::capture(*this);
+  uint32_t sections = mDirtySections;
+  mDirtySections = 0;
+  mMeshingSections = sections;
+  uint generation = ++mMeshGeneration;
+  Job::Decl cpuMeshDecl([this, snapshot, sections, generation] {
+    section_meshers_t meshers;
+    constructCPUMesh(*snapshot, sections, meshers);
+
+    S<Job::Counter> gpuMeshJob = Job::create([this, sections, generation, meshers]() mutable {
+      // superseded by a sync rebuild, or the chunk was destroyed (maybe recycled) meanwhile
+      if(generation != mMeshGeneration) {
+        releaseMeshers(meshers);
+        return;
       }
-    }
-    mMesher.end();
+      constructGPUMesh(sections, meshers);
+      mMeshingSections = 0;
 
-    S<Job::Counter> gpuMeshJob = Job::create([this] {
-      mMesh = mMesher.createMesh<vertex_lit_t>();
-      rebuildGpuMetaData();
-      mState = CHUNK_STATE_READY;
-      mIsDirty = false;
+      // edited while meshing, go again
+      mState = isDirty() ? CHUNK_STATE_LOADED_NO_MESH : CHUNK_STATE_READY;
     }, Job::CAT_MAIN_THREAD);
     Job::dispatch(gpuMeshJob);
   });
-  S<Job::Counter> cpuMeshJob = Job::create(constructCPUMesh, Job::CAT_GENERIC_SLOW);
-  constexpr size_t s = sizeof(constructCPUMesh);
+  S<Job::Counter> cpuMeshJob = Job::create(cpuMeshDecl, Job::CAT_GENERIC_SLOW);
+  constexpr size_t s = sizeof(cpuMeshDecl);
 
   Job::dispatch(cpuMeshJob);
   return cpuMeshJob;
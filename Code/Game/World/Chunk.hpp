@@ -2,6 +2,9 @@
 #include <utility>
 #include "Engine/Core/common.hpp"
 #include "Game/World/Block.hpp"
+#include "Game/World/BlockStorage.hpp"
+#include "Game/World/ChunkLayout.hpp"
+#include "Game/World/ChunkMeshFormat.hlsli"
 #include "Engine/Math/Primitives/ivec3.hpp"
 #include "Engine/Math/Primitives/ivec2.hpp"
 #include "Engine/Graphics/Model/Mesher.hpp"
@@ -12,10 +15,32 @@
 class Chunk;
 class Mesh;
 class World;
+class ChunkSnapshot;
+class PaddedChunk;
 class ChunkCoords;
+struct block_edit_t;
+struct routed_edit_t;
+class PendingEdits;
+struct chunk_quad_t;
+enum eBiome: uint8_t;
 struct aabb3;
 
-using BlockIndex = uint16_t;
+using BlockIndex = GameChunkLayout::index_t;
+
+/*
+ * How block coords map to a `BlockIndex`, picked at compile time.
+ *   LINEAR: x | y << kSizeBitX | z << (kSizeBitX + kSizeBitY), rows along x are contiguous and
+ *           the z neighbors are a whole layer (kSizeX * kSizeY blocks) away.
+ *   MORTON: x, y and the low 4 bits of z interleaved (z-order) in the low 12 bits, the rest of z on top.
+ *           3D neighbors mostly land within a few cache lines, and a 16-high section stays contiguous.
+ * Saves and the gpu volume are linear either way, see `BlockCoords::fromLinear`.
+ */
+#define BLOCK_INDEX_LINEAR 0
+#define BLOCK_INDEX_MORTON 1
+
+#ifndef BLOCK_INDEX_MODE
+#define BLOCK_INDEX_MODE BLOCK_INDEX_LINEAR
+#endif
 
 enum eChunkState {
   CHUNK_STATE_INIT_READY,
@@ -42,15 +67,37 @@ public:
   static aabb3 blockBounds(Chunk* chunk, const BlockCoords& coords);
   static vec3  blockCenterPosition(Chunk* chunk, BlockIndex index);
   static BlockIndex toIndex(BlockIndex x, BlockIndex y, BlockIndex z);
+  // index of the block at `linear` in x | y << kSizeBitX | z << (kSizeBitX + kSizeBitY) order
+  static BlockIndex fromLinear(uint linear);
+
+protected:
+  // 4 bits to every 3rd bit and back
+  static constexpr BlockIndex mortonSpread(BlockIndex v) {
+    return BlockIndex((v & 1) | ((v & 2) << 2) | ((v & 4) << 4) | ((v & 8) << 6));
+  }
+  static constexpr BlockIndex mortonCompact(BlockIndex v) {
+    return BlockIndex((v & 1) | ((v >> 2) & 2) | ((v >> 4) & 4) | ((v >> 6) & 8));
+  }
 };
 
-class ChunkCoords: public ivec2 {
+// columns are addressed in xy only, cubic chunks stack up along z too (CUBIC_CHUNKS in ChunkDims.hlsli)
+#if CUBIC_CHUNKS
+using chunk_coords_t = ivec3;
+#else
+using chunk_coords_t = ivec2;
+#endif
+
+class ChunkCoords: public chunk_coords_t {
 public:
-  using ivec2::ivec2;
-  using ivec2::operator=;
+  using chunk_coords_t::chunk_coords_t;
+  using chunk_coords_t::operator=;
 
   ChunkCoords() {};
-  ChunkCoords(const ivec2& copy): ivec2(copy) {};
+  ChunkCoords(const chunk_coords_t& copy): chunk_coords_t(copy) {};
+#if CUBIC_CHUNKS
+  // the slab at z = 0
+  ChunkCoords(int x, int y): chunk_coords_t(x, y, 0) {};
+#endif
   bool operator>(const ChunkCoords& rhs) const;
   bool operator<(const ChunkCoords& rhs) const {
     return !(*this > rhs || *this == rhs);
@@ -66,34 +113,73 @@ namespace std {
   struct hash<ChunkCoords> {
     size_t operator()(const ChunkCoords& c) const noexcept {
       std::hash<int> hasher;
+#if CUBIC_CHUNKS
+      return  (hasher(c.x) ^ hasher(c.y) << 1 ^ hasher(c.z) << 2);
+#else
       return  (hasher(c.x) ^ hasher(c.y) << 1);
+#endif
     };
   };
 }
 
 class Chunk {
+  friend class ChunkBenchmark;
+  friend class ChunkSnapshot;
+  friend class WorldGenerator;
   Chunk() = default;
 public:
   static Chunk sInvalidChunk;
   
-  static constexpr BlockIndex kSizeBitX = 4;
-  static constexpr BlockIndex kSizeBitY = 4;
-  static constexpr BlockIndex kSizeBitZ = 8;
-
-  static constexpr uint kTotalBlockCount = 1 << (kSizeBitX + kSizeBitY + kSizeBitZ);
-
-  static constexpr BlockIndex kSizeX = 1 << kSizeBitX;
-  static constexpr BlockIndex kSizeY = 1 << kSizeBitY;
-  static constexpr BlockIndex kSizeZ = 1 << kSizeBitZ;
-
+  using Layout = GameChunkLayout;
+
+  static constexpr BlockIndex kSizeBitX = Layout::kSizeBitX;
+  static constexpr BlockIndex kSizeBitY = Layout::kSizeBitY;
+  static constexpr BlockIndex kSizeBitZ = Layout::kSizeBitZ;
+
+  static constexpr uint kTotalBlockCount = Layout::kTotalBlockCount;
+
+  // chunk is stacked up from 16-high sections, uniform ones (all air, all stone) cost nothing
+  static constexpr BlockIndex kSectionBitZ = Layout::kSectionBitZ;
+  static constexpr BlockIndex kSectionSizeZ = Layout::kSectionSizeZ;
+  static constexpr uint kSectionCount = Layout::kSectionCount;
+  static constexpr uint kSectionBlockCount = Layout::kSectionBlockCount;
+
+  using Storage = Layout::Storage;
+  // a row of blocks along x, bit x
+  using row_t = Layout::row_t;
+  using row_ext_t = Layout::row_ext_t;
+
+  static constexpr BlockIndex kSizeX = Layout::kSizeX;
+  static constexpr BlockIndex kSizeY = Layout::kSizeY;
+  static constexpr BlockIndex kSizeZ = Layout::kSizeZ;
+
+  // z range the terrain is generated in. cubic chunks keep the shape of the 256 high columns
+#if CUBIC_CHUNKS
+  static constexpr int kTerrainHeight = 256;
+#else
+  static constexpr int kTerrainHeight = kSizeZ;
+#endif
+
+  // bits of each axis in a `BlockIndex`
+#if BLOCK_INDEX_MODE == BLOCK_INDEX_MORTON
+  static_assert(kSizeBitX == 4 && kSizeBitY == 4 && kSizeBitZ >= 4 && kSizeBitZ <= 8, "morton index is laid out for 16x16 columns");
+  static constexpr BlockIndex kSizeMaskX = 0x0249;
+  static constexpr BlockIndex kSizeMaskY = 0x0492;
+#else
   static constexpr BlockIndex kSizeMaskX = BlockIndex(~((~0u) << kSizeBitX));
   static constexpr BlockIndex kSizeMaskY = BlockIndex(((1u << (kSizeBitX+kSizeBitY)) - 1u) ^ kSizeMaskX);
-  static constexpr BlockIndex kSizeMaskZ = BlockIndex((~0u) ^ (kSizeMaskX | kSizeMaskY));
+#endif
+  static constexpr BlockIndex kSizeMaskZ = BlockIndex((kTotalBlockCount - 1u) ^ (kSizeMaskX | kSizeMaskY));
 
   Chunk(ChunkCoords coords);
 
   ~Chunk();
 
+  // reuse a destroyed chunk for `coords`, see `ChunkPool`
+  void recycle(ChunkCoords coords);
+  // frees blocks, meshes and the gpu volume of a chunk going back to the pool, only scratch capacity stays
+  void releaseMemory();
+
   eChunkState state() const { return mState; };
 
   enum eNeighbor: uint8_t {
@@ -101,10 +187,17 @@ public:
     NEIGHBOR_NEG_X,
     NEIGHBOR_POS_Y,
     NEIGHBOR_NEG_Y,
+#if CUBIC_CHUNKS
+    NEIGHBOR_POS_Z,
+    NEIGHBOR_NEG_Z,
+#endif
 
     NUM_NEIGHBOR,
   };
 
+  static eNeighbor opposite(eNeighbor side) { return eNeighbor(side ^ 1); }
+  static ChunkCoords neighborOffset(eNeighbor side);
+
   class Iterator {
     friend class Chunk;
 
@@ -129,6 +222,47 @@ public:
 
   };
 
+  // proxy to one block in the chunk storage, whatever the layout is.
+  // reads as `Block::kInvalid` and drops writes when it does not point to any storage.
+  class BlockRef {
+    friend class Chunk;
+
+  public:
+    BlockRef(Storage* storage, BlockIndex index): mStorage(storage), mIndex(index) {}
+
+    block_id_t id() const { return mStorage != nullptr ? mStorage->id(mIndex) : Block::kInvalid.id(); }
+    uint8_t light() const { return mStorage != nullptr ? mStorage->light(mIndex) : Block::kInvalid.light(); }
+    uint8_t bitFlags() const { return mStorage != nullptr ? mStorage->flags(mIndex) : Block::kInvalid.bitFlags(); }
+
+    const BlockDef& type() const { return *BlockDef::get(id()); }
+    bool opaque() const { return bitFlags() & Block::kOpaqueFlag; }
+    bool lightDirty() const  { return bitFlags() & Block::kLightDirtyFlag;  }
+
+    uint8_t indoorLight() const { return light() & Block::kIndoorLightMask; }
+    uint8_t outdoorLight() const { return (light() & Block::kOutdoorLightMask) >> 4; }
+
+    void setIndoorLight(uint8_t amount) { setLight((amount & Block::kIndoorLightMask) | (light() & (~Block::kIndoorLightMask))); }
+    void setOutdoorLight(uint8_t amount) { setLight(((amount << 4) & Block::kOutdoorLightMask) | (light() & (~Block::kOutdoorLightMask))); }
+    void setSky() { setOutdoorLight(Block::kMaxOutdoorLight); }
+    bool exposedToSky() const { return outdoorLight() == Block::kMaxOutdoorLight; }
+    void setLightDirty() { setBitFlags(bitFlags() | Block::kLightDirtyFlag); }
+    void clearLightDirty() { setBitFlags(bitFlags() & (~Block::kLightDirtyFlag)); }
+
+    operator Block() const { return mStorage != nullptr ? mStorage->get(mIndex) : Block::kInvalid; }
+
+    // so `iter->opaque()` keeps working on a proxy returned by value
+    BlockRef* operator->() { return this; }
+    const BlockRef* operator->() const { return this; }
+
+  protected:
+    void resetFromDef(const BlockDef& def);
+    void setLight(uint8_t light) { if(mStorage != nullptr) mStorage->setLight(mIndex, light); }
+    void setBitFlags(uint8_t flags) { if(mStorage != nullptr) mStorage->setFlags(mIndex, flags); }
+
+    Storage* mStorage;
+    BlockIndex mIndex;
+  };
+
   class BlockIter {
     friend class Chunk;
 
@@ -154,6 +288,9 @@ public:
     void reset(BlockDef& def);
     void dirtyLight();
 
+    // through the chunk opacity masks, does not touch the block storage
+    bool opaque() const;
+
     aabb3 bounds() const {
       return BlockCoords::blockBounds(chunk.self, blockIndex);
     }
@@ -170,9 +307,9 @@ public:
     }
     BlockIter operator+(const BlockCoords& deltaCoords) const;
 
-    Block& operator*() const;
-    Block* operator->() const;
-    Block* block() const;
+    BlockRef operator*() const;
+    BlockRef operator->() const;
+    BlockRef block() const;
     bool operator==(const BlockIter& rhs) const { return chunk == rhs.chunk && blockIndex == rhs.blockIndex; };
     bool operator!=(const BlockIter& rhs) const { return !(*this == rhs); };
     Iterator chunk;
@@ -187,18 +324,41 @@ public:
   void afterRegisterToWorld();
   void onUpdate();
 
-  Mesh* mesh() const { return mMesh; }
+  // a mesh per section, null where the section shows nothing
+  Mesh* sectionMesh(uint section) const { return mSectionMeshes[section]; }
 
   void onDestroy();
   ChunkCoords coords() const { return mCoords; };
 
   aabb3 bounds() const { return mBounds; }
-  const Block& block(uint index) const { return mBlocks[index]; }
-  Block& block(BlockIndex index) { return mBlocks[index]; }
+  Block block(BlockIndex index) const { return mBlocks.get(index); }
+  bool opaque(BlockIndex index) const { 
+    BlockCoords coords = BlockCoords::fromIndex(index);
+    return ((mClearRows[coords.y | (coords.z << kSizeBitY)] >> coords.x) & 1u) == 0; 
+  }
+  BlockRef block(BlockIndex index) { return { &mBlocks, index }; }
+  size_t memoryUsage() const { 
+    return sizeof(*this) - sizeof(mBlocks) + mBlocks.memoryUsage() + mGpuScratch.capacity() * sizeof(Block); 
+  }
 
-  bool isDirty() const { return mIsDirty; }
-  void setDirty() { mIsDirty = true; mState = CHUNK_STATE_LOADED_NO_MESH; };
+  // bit per section
+  static constexpr uint32_t kAllSections = uint32_t(~0ull >> (64 - kSectionCount));
+  static_assert(kSectionCount <= 32, "dirty sections are a 32 bit mask");
+
+  bool isDirty() const { return mDirtySections != 0; }
+  void setDirty() { setSectionsDirty(kAllSections); }
+  // only these sections are remeshed. a mesh job in flight keeps its state, what it did not cover stays dirty for the next one
+  void setSectionsDirty(uint32_t sections) { 
+    mDirtySections |= sections; 
+    mVersion++; 
+    if(mState != CHUNK_STATE_MESH_CONSTRUCTING) mState = CHUNK_STATE_LOADED_NO_MESH; 
+  };
+  // sections of this chunk that can show a face of block `index`: its own, and the one across when it sits on a section boundary
+  static uint32_t sectionsShowing(BlockIndex index);
+  uint version() const { return mVersion; }
 
+  // both only remesh the dirty sections. the sync one is for edits that have to show this frame,
+  // it also takes over the sections of a job in flight, whose result is then dropped
   bool reconstructMesh();
   S<Job::Counter> reconstructMeshAsync();
   Iterator iterator();
@@ -211,66 +371,158 @@ public:
   void setNeighbor(eNeighbor loc, Chunk& chunk) { mNeighbors[loc] = &chunk; }
 
   void onRegisterToWorld(World* world);
+  // null while the chunk is not registered, in the pool for example
+  World* world() const { return mOwner; }
   void onUnregisterFromWorld();
 
+  // worst case, every block its own run
+  size_t maxSerializedSize() const;
   size_t serialize(byte_t* data, size_t maxWrite) const;
-  void deserialize(byte_t* data, size_t maxRead);
+  // false if the data is not a chunk of this layout
+  bool deserialize(byte_t* data, size_t maxRead);
 
   void markSavePending() { mSavePending =true;}
 
   bool valid() const;
   bool invalid() const { return !valid(); }
-  bool renderable() const { return mMesh != nullptr; }
+  bool renderable() const { return mMeshed; }
   static Iterator invalidIter() { return { sInvalidChunk }; }
 
   void resetBlock(BlockIndex index, BlockDef& def);
+  void resetSection(uint section, BlockDef& def);
+
+  // bulk writes for generation and loading: a section at a time, ids and static flags in block index order.
+  // the opacity masks are set right away, heightmap and dirty state once for the chunk in `endBulkWrite`
+  void writeSection(uint section, const block_id_t* ids, const uint8_t* flags);
+  void writeSection(uint section, const BlockDef& def);
+  void endBulkWrite();
+
+  // parked `PendingEdits` for this chunk. `applyEdits` goes with the bulk writes, before `endBulkWrite`.
+  // `applyLiveEdits` is for a chunk in the world, block by block like a player edit but without marking it for
+  // a save. both skip opaque blocks
+  void applyEdits(span<const block_edit_t> edits);
+  void applyLiveEdits(span<const block_edit_t> edits);
+  // what `store` has parked for this chunk, less the edits of writers it took before, see `mFedBy`
+  std::vector<block_edit_t> takeNewEdits(PendingEdits& store);
+
+  // bit x of the row (y, z). `y` can reach into the y neighbors, `z` out of the chunk reads opaque
+  row_t opaqueRow(int y, int z) const;
+  // kSizeX + 2 bits, `opaqueRow` shifted up by one with the x neighbors' adjacent blocks at bit 0 and kSizeX + 1
+  row_ext_t opaqueRowExtended(int y, int z) const;
+  // highest opaque block in column (x, y) below `belowZ`, -1 if none
+  int highestOpaque(BlockIndex x, BlockIndex y, int belowZ) const;
+  // z right above the top opaque block of column (x, y), 0 if the column has none
+  uint16_t height(BlockIndex x, BlockIndex y) const { return mHeightMap[x | (y << kSizeBitX)]; }
+  uint16_t maxHeight() const { return mMaxHeight; }
+  // `bounds` cut down to the top of the terrain
+  aabb3 terrainBounds() const;
+  // 3x3x3 opacity around the block, bit (dx+1) + (dy+1)*3 + (dz+1)*9
+  static uint32_t opaqueNeighborhood(const BlockIter& center);
 
   const Texture3::sptr_t& gpuVolume() { return mChunkGPUData == nullptr ? sInvalidChunk.mChunkGPUData : mChunkGPUData; }
+  // blocks or light of these sections changed, unlike `setSectionsDirty` not for a neighbor's sake
+  void setVolumeDirty(uint32_t sections) { mVolumeDirtySections |= sections; }
+  // unpacks the volume sections that changed and uploads it again, nothing to do if none did
   void rebuildGpuMetaData();
 protected:
 
-  void addBlock(const BlockIter& block, const vec3& pivot);
+  // a `MesherPool` mesher per section of a build, null where there is nothing to draw
+  using section_meshers_t = std::array<Mesher*, kSectionCount>;
+
+  // builds `sections` from the quads CHUNK_MESHER_MODE finds (ChunkMeshFormat.hlsli) into `meshers`.
+  // only reads the snapshot, any thread
+  void constructCPUMesh(const ChunkSnapshot& snapshot, uint32_t sections, section_meshers_t& meshers);
+  // main thread, hands the meshers back to the pool
+  void constructGPUMesh(uint32_t sections, section_meshers_t& meshers);
+  static void releaseMeshers(section_meshers_t& meshers);
+  // `blocks` has to hold the section and the layer on either side
+  void collectQuads(const ChunkSnapshot& snapshot, const PaddedChunk& blocks, uint section, std::vector<chunk_quad_t>& quads);
+  void collectFaceQuads(const ChunkSnapshot& snapshot, const PaddedChunk& blocks, uint section, std::vector<chunk_quad_t>& quads);
+  void collectGreedyQuads(const ChunkSnapshot& snapshot, const PaddedChunk& blocks, uint section, std::vector<chunk_quad_t>& quads);
+  static void addQuad(Mesher& mesher, const vec3& pivot, const chunk_quad_t& quad);
   void markBlockLightDirty(const BlockIter& block);
-
-  void generateBlocks();
+  void setOpaque(BlockIndex index, bool opaque);
+  void setSectionOpaque(uint section, bool opaque);
+  void setSectionOpacityMasks(uint section, bool opaque);
+  void setColumnHeight(uint column, uint16_t height);
+  void rebuildHeightMap();
+  void markBoundaryLightDirty(eNeighbor side);
+
+  // terrain and trees, then the edits parked for this chunk in `PendingEdits::get()` so far
+  void generateBlocks(uint seed);
+  // the part of `generateBlocks` that only depends on the seed and the coords. tree blocks past the border go
+  // to `overflow`, the bulk write is left open for `applyEdits` and `endBulkWrite`
+  void generateTerrain(uint seed, PendingEdits& overflow);
+  // trees on the temperate columns, whatever crosses the chunk border goes to `overflow`
+  void plantTrees(uint seed, const eBiome* biomes, PendingEdits& overflow);
   void initLights();
+  // nothing above column (x, y) blocks the sky. cubic chunks ask the chunk on top, an unloaded one counts as open
+  bool skyAbove(BlockIndex x, BlockIndex y) const;
   bool neighborsLoaded() const;
 
 
-  std::array<Block, kTotalBlockCount> mBlocks; // 0xffff
+  Storage mBlocks; // 0xffff
+
+  // opacity masks, kept in sync with the block flags by `setOpaque`. bits are set where the block is NOT
+  // opaque, so the zero initialized masks match the default (opaque) blocks
+  static constexpr uint kColumnWordCount = (kSizeZ + 63) / 64;
+  std::array<row_t, kSizeY * kSizeZ> mClearRows = {};                                         // [y | z << kSizeBitY], bit x
+  std::array<std::array<uint64_t, kColumnWordCount>, kSizeX * kSizeY> mClearColumns = {};     // [x | y << kSizeBitX], bit z
+  // follows the opacity masks, rebuilt after generation and loading, incremental for edits
+  std::array<uint16_t, kSizeX * kSizeY> mHeightMap = {};
+  uint16_t mMaxHeight = 0;
   ChunkCoords mCoords = {~int(0), ~int(0)};
   std::array<Chunk*, NUM_NEIGHBOR> mNeighbors 
-    { &sInvalidChunk, &sInvalidChunk, &sInvalidChunk, &sInvalidChunk, };
-  Mesher mMesher;
+    { &sInvalidChunk, &sInvalidChunk, &sInvalidChunk, &sInvalidChunk, 
+#if CUBIC_CHUNKS
+      &sInvalidChunk, &sInvalidChunk,
+#endif
+    };
   World* mOwner = nullptr;
   aabb3 mBounds;
   
-  owner<Mesh*> mMesh = nullptr;
+  std::array<owner<Mesh*>, kSectionCount> mSectionMeshes = {};
+  bool mMeshed = false;
   Texture3::sptr_t mChunkGPUData = nullptr;
+  // the volume in linear order as last uploaded, only the dirty sections are unpacked into it again
+  std::vector<Block> mGpuScratch;
+  uint32_t mVolumeDirtySections = kAllSections;
 
   bool mSavePending = false;
-  bool mIsDirty = true;
+  // one bit per `PendingEdits::sourceSlot` whose edits are in the blocks, saved with them. a writer that is
+  // generated again pushes the same edits again, they must not refill what was dug out of them
+  uint32_t mFedBy = 0;
+  // what generation wrote past the borders, saved and pushed again on load for neighbors generated later
+  std::vector<routed_edit_t> mBorderEdits;
+  uint32_t mDirtySections = kAllSections;
+  uint mVersion = 0;
+  // bumped by every mesh build and by destroy, a job whose build is not the latest any more drops its result.
+  // never reset, a recycled chunk must not take a mesh of its previous life
+  uint mMeshGeneration = 0;
+  // what the job in flight is building
+  uint32_t mMeshingSections = 0;
 
   eChunkState mState = CHUNK_STATE_INIT_READY;
 };
 
 inline BlockIndex BlockCoords::toIndex() const {
-  BlockIndex index = 0;
   // EXPECTS(x >=0 && x < Chunk::kSizeX);
   // EXPECTS(y >=0 && y < Chunk::kSizeY);
   // EXPECTS(z >=0 && z < Chunk::kSizeZ);
 
-  index = (x & Chunk::kSizeMaskX)
-        | ((y << Chunk::kSizeBitX) & Chunk::kSizeMaskY)
-        | ((z << (Chunk::kSizeBitX + Chunk::kSizeBitY)) & Chunk::kSizeMaskZ);
-
-  return index;
+  return toIndex(BlockIndex(x), BlockIndex(y), BlockIndex(z));
 }
 
 inline BlockCoords BlockCoords::fromIndex(BlockIndex index) {
-  return { Chunk::kSizeMaskX & index, 
-          (Chunk::kSizeMaskY & index) >> Chunk::kSizeBitX,
-          (Chunk::kSizeMaskZ & index) >> (Chunk::kSizeBitX + Chunk::kSizeBitY) };
+#if BLOCK_INDEX_MODE == BLOCK_INDEX_MORTON
+  return { mortonCompact(index), 
+           mortonCompact(index >> 1), 
+           mortonCompact(index >> 2) | ((index >> 12) << 4) };
+#else
+  return { int(Chunk::kSizeMaskX & index), 
+           int((Chunk::kSizeMaskY & index) >> Chunk::kSizeBitX),
+           int((Chunk::kSizeMaskZ & index) >> (Chunk::kSizeBitX + Chunk::kSizeBitY)) };
+#endif
 }
 
 inline bool Chunk::valid() const {
@@ -279,7 +531,22 @@ inline bool Chunk::valid() const {
 }
 
 inline BlockIndex BlockCoords::toIndex(BlockIndex x, BlockIndex y, BlockIndex z) {
+#if BLOCK_INDEX_MODE == BLOCK_INDEX_MORTON
+  return mortonSpread(x & 0xf) 
+       | (mortonSpread(y & 0xf) << 1) 
+       | (mortonSpread(z & 0xf) << 2) 
+       | (((z >> 4) << 12) & 0xf000);
+#else
   return (x & Chunk::kSizeMaskX)
         | ((y << Chunk::kSizeBitX) & Chunk::kSizeMaskY)
         | ((z << (Chunk::kSizeBitX + Chunk::kSizeBitY)) & Chunk::kSizeMaskZ);
+#endif
+}
+
+inline BlockIndex BlockCoords::fromLinear(uint linear) {
+#if BLOCK_INDEX_MODE == BLOCK_INDEX_MORTON
+  return toIndex(BlockIndex(linear & 0xf), BlockIndex((linear >> 4) & 0xf), BlockIndex(linear >> 8));
+#else
+  return BlockIndex(linear);
+#endif
 }
@@ -0,0 +1,38 @@
+#ifndef __CHUNK_DIMS_H__
+#define __CHUNK_DIMS_H__
+
+// chunk dimensions, included by both the game code (`Chunk`, `GPUVolume`) and the shaders so they stay in sync.
+// to try another layout, define them in the C/C++ and the HLSL preprocessor definitions of the project.
+
+// CUBIC_CHUNKS: chunk coords are 3D and chunks stack up along z as well, so only the slabs close to
+// the viewer are loaded. otherwise every chunk is a full height column
+#ifndef CUBIC_CHUNKS
+#define CUBIC_CHUNKS 0
+#endif
+
+#ifndef CHUNK_SIZE_BIT_X
+#define CHUNK_SIZE_BIT_X 4
+#endif
+
+#ifndef CHUNK_SIZE_BIT_Y
+#define CHUNK_SIZE_BIT_Y 4
+#endif
+
+#ifndef CHUNK_SIZE_BIT_Z
+#if CUBIC_CHUNKS
+#define CHUNK_SIZE_BIT_Z 4
+#else
+#define CHUNK_SIZE_BIT_Z 8
+#endif
+#endif
+
+#define CHUNK_SIZE_X (1 << CHUNK_SIZE_BIT_X)
+#define CHUNK_SIZE_Y (1 << CHUNK_SIZE_BIT_Y)
+#define CHUNK_SIZE_Z (1 << CHUNK_SIZE_BIT_Z)
+
+// the world volume around the player is VOLUME_SIZE_XY blocks wide, tiled by whole chunks
+#define VOLUME_SIZE_XY 256
+#define VOLUME_TILE_COUNT_X (VOLUME_SIZE_XY >> CHUNK_SIZE_BIT_X)
+#define VOLUME_TILE_COUNT_Y (VOLUME_SIZE_XY >> CHUNK_SIZE_BIT_Y)
+
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+#include <type_traits>
+#include "Engine/Core/common.hpp"
+#include "Game/World/BlockStorage.hpp"
+#include "Game/World/ChunkDims.hlsli"
+
+// everything derived from the chunk dimensions, so other sizes can be instantiated side by side (see `ChunkBenchmark`).
+// the game itself runs one layout, `GameChunkLayout`, picked by the CHUNK_SIZE_BIT_* in ChunkDims.hlsli
+template<uint kBitX, uint kBitY, uint kBitZ>
+struct ChunkLayout {
+  static_assert(kBitX + kBitY + kBitZ <= 32, "chunk too large for a 32 bit block index");
+
+  static constexpr uint kSizeBitX = kBitX;
+  static constexpr uint kSizeBitY = kBitY;
+  static constexpr uint kSizeBitZ = kBitZ;
+
+  static constexpr uint kSizeX = 1u << kSizeBitX;
+  static constexpr uint kSizeY = 1u << kSizeBitY;
+  static constexpr uint kSizeZ = 1u << kSizeBitZ;
+
+  static constexpr uint kTotalBlockCount = 1u << (kSizeBitX + kSizeBitY + kSizeBitZ);
+
+  // sections are 16 high, or the whole chunk when it is shorter than that
+  static constexpr uint kSectionBitZ = kSizeBitZ < 4 ? kSizeBitZ : 4;
+  static constexpr uint kSectionSizeZ = 1u << kSectionBitZ;
+  static constexpr uint kSectionCount = 1u << (kSizeBitZ - kSectionBitZ);
+  static constexpr uint kSectionBlockCount = 1u << (kSizeBitX + kSizeBitY + kSectionBitZ);
+
+  // smallest types holding a block index, a row of blocks along x, and a row with one neighbor on each side
+  using index_t = std::conditional_t<(kSizeBitX + kSizeBitY + kSizeBitZ <= 16), uint16_t, uint32_t>;
+  using row_t = std::conditional_t<(kSizeX <= 16), uint16_t, std::conditional_t<(kSizeX <= 32), uint32_t, uint64_t>>;
+  using row_ext_t = std::conditional_t<(kSizeX + 2 <= 32), uint32_t, uint64_t>;
+  static_assert(kSizeX + 2 <= 64, "rows along x have to fit in 64 bits");
+
+  static constexpr row_t kRowMask = row_t(~row_t(0) >> (sizeof(row_t) * 8 - kSizeX));
+
+  using Storage = SectionedBlockStorage<kTotalBlockCount, kSectionBlockCount>;
+
+  // what a chunk spends on its opacity masks and heightmap on top of the block storage
+  static constexpr size_t kMaskMemory = 
+    sizeof(row_t) * kSizeY * kSizeZ + sizeof(uint64_t) * ((kSizeZ + 63) / 64) * kSizeX * kSizeY + sizeof(uint16_t) * kSizeX * kSizeY;
+};
+
+using GameChunkLayout = ChunkLayout<CHUNK_SIZE_BIT_X, CHUNK_SIZE_BIT_Y, CHUNK_SIZE_BIT_Z>;
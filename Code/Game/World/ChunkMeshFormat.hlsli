@@ -0,0 +1,30 @@
+#ifndef __CHUNK_MESH_FORMAT_H__
+#define __CHUNK_MESH_FORMAT_H__
+
+// how chunk meshes are built and read, included by both `Chunk` and the gbuffer shaders so they agree.
+// like ChunkDims.hlsli, define them in the C/C++ and the HLSL preprocessor definitions of the project.
+
+// CHUNK_MESHER_MODE:
+// FACES: a quad per visible block face, uv is the sprite rect in the atlas
+// GREEDY: coplanar faces with the same sprite and light merge into rectangles within a section. uv counts
+//         blocks across the quad and the sprite coords ride in color.b and color.a, the pixel shader wraps
+#define CHUNK_MESHER_FACES  0
+#define CHUNK_MESHER_GREEDY 1
+
+#ifndef CHUNK_MESHER_MODE
+#define CHUNK_MESHER_MODE CHUNK_MESHER_FACES
+#endif
+
+// sprites across the block atlas, `BlockDef::kSpritesheetUnitCount*`
+#define SPRITESHEET_UNIT_COUNT_X 32
+#define SPRITESHEET_UNIT_COUNT_Y 32
+
+// the packed 8 byte chunk vertex, `chunk_vertex_t`, as two uints:
+// position: x | y << CHUNK_VERTEX_SHIFT_Y | z << CHUNK_VERTEX_SHIFT_Z | face << CHUNK_VERTEX_SHIFT_FACE, chunk-local corner
+// look:     sprite | light << CHUNK_VERTEX_SHIFT_LIGHT, light is indoor in the low nibble and outdoor in the high one
+#define CHUNK_VERTEX_SHIFT_Y     6
+#define CHUNK_VERTEX_SHIFT_Z     12
+#define CHUNK_VERTEX_SHIFT_FACE  22
+#define CHUNK_VERTEX_SHIFT_LIGHT 10
+
+#endif
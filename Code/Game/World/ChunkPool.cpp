@@ -0,0 +1,46 @@
+#include "ChunkPool.hpp"
+
+ChunkPool::~ChunkPool() {
+  for(uint s = 0; s < mSlabs.size(); s++) {
+    Chunk* slab = (Chunk*)mSlabs[s];
+    uint used = s + 1 == mSlabs.size() ? mSlabUsed : kSlabSize;
+    for(uint i = 0; i < used; i++) {
+      slab[i].~Chunk();
+    }
+    ::operator delete(mSlabs[s]);
+  }
+}
+
+owner<Chunk*> ChunkPool::acquire(ChunkCoords coords) {
+  if(!mAvailable.empty()) {
+    Chunk* chunk = mAvailable.back();
+    mAvailable.pop_back();
+    chunk->recycle(coords);
+
+    mStats.hits++;
+    mStats.available = (uint)mAvailable.size();
+    return chunk;
+  }
+
+  if(mSlabUsed == kSlabSize) {
+    mSlabs.push_back(::operator new(sizeof(Chunk) * kSlabSize));
+    mSlabUsed = 0;
+  }
+
+  Chunk* chunk = new ((Chunk*)mSlabs.back() + mSlabUsed) Chunk(coords);
+  mSlabUsed++;
+
+  mStats.misses++;
+  mStats.constructed++;
+  return chunk;
+}
+
+void ChunkPool::release(owner<Chunk*> chunk) {
+  EXPECTS(chunk->valid());
+  // an idle chunk in the pool holds no blocks, the pool stays as big as the peak chunk count
+  chunk->releaseMemory();
+  mAvailable.push_back(chunk);
+
+  mStats.released++;
+  mStats.available = (uint)mAvailable.size();
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "Engine/Core/common.hpp"
+#include "Game/World/Chunk.hpp"
+
+// recycles `Chunk` objects instead of new/delete on every activation. chunks are carved out of slabs,
+// a released chunk frees its blocks, meshes and gpu volume right away and only keeps its gpu scratch capacity
+// for the next user.
+class ChunkPool {
+public:
+  static constexpr uint kSlabSize = 16;
+
+  struct stats_t {
+    uint hits = 0;       // acquire served by a recycled chunk
+    uint misses = 0;     // acquire had to construct a new chunk
+    uint released = 0;
+    uint constructed = 0;
+    uint available = 0;
+
+    float hitRate() const { return hits + misses == 0 ? 0.f : float(hits) / float(hits + misses); }
+  };
+
+  ChunkPool() = default;
+  ChunkPool(const ChunkPool&) = delete;
+  ChunkPool& operator=(const ChunkPool&) = delete;
+  ~ChunkPool();
+
+  owner<Chunk*> acquire(ChunkCoords coords);
+  void release(owner<Chunk*> chunk);
+
+  const stats_t& stats() const { return mStats; }
+
+protected:
+  std::vector<void*> mSlabs;
+  uint mSlabUsed = kSlabSize;
+  std::vector<Chunk*> mAvailable;
+  stats_t mStats;
+};
@@ -0,0 +1,175 @@
+#include "ChunkSnapshot.hpp"
+
+S<const ChunkSnapshot> ChunkSnapshot::capture(const Chunk& chunk) {
+  S<ChunkSnapshot> snapshot = std::make_shared<ChunkSnapshot>();
+
+  snapshot->mVersion = chunk.mVersion;
+  snapshot->mCoords = chunk.mCoords;
+  snapshot->mCenter = chunk.mBlocks.view();
+  snapshot->mClearRows = chunk.mClearRows;
+
+  for(uint i = 0; i < Chunk::NUM_NEIGHBOR; i++) {
+    const Chunk* neighbor = chunk.mNeighbors[i];
+    snapshot->mNeighborValid[i] = neighbor->valid();
+    snapshot->mNeighborClearRows[i] = neighbor->mClearRows;
+    if(neighbor->valid()) {
+      snapshot->mNeighbors[i] = neighbor->mBlocks.view();
+    }
+  }
+
+  return snapshot;
+}
+
+Block ChunkSnapshot::block(int x, int y, int z) const {
+  const View* view = &mCenter;
+#if CUBIC_CHUNKS
+  if(z < 0 || z >= Chunk::kSizeZ) {
+    // straight above or below only, the diagonals are not captured
+    if(x < 0 || x >= Chunk::kSizeX || y < 0 || y >= Chunk::kSizeY) return Block::kInvalid;
+    view = neighbor(z < 0 ? Chunk::NEIGHBOR_NEG_Z : Chunk::NEIGHBOR_POS_Z);
+    z = z < 0 ? z + Chunk::kSizeZ : z - Chunk::kSizeZ;
+  }
+#else
+  if(z < 0 || z >= Chunk::kSizeZ) return Block::kInvalid;
+#endif
+
+  if(x < 0) {
+    view = neighbor(Chunk::NEIGHBOR_NEG_X);
+    x += Chunk::kSizeX;
+  } else if(x >= Chunk::kSizeX) {
+    view = neighbor(Chunk::NEIGHBOR_POS_X);
+    x -= Chunk::kSizeX;
+  } else if(y < 0) {
+    view = neighbor(Chunk::NEIGHBOR_NEG_Y);
+    y += Chunk::kSizeY;
+  } else if(y >= Chunk::kSizeY) {
+    view = neighbor(Chunk::NEIGHBOR_POS_Y);
+    y -= Chunk::kSizeY;
+  }
+
+  if(view == nullptr) return Block::kInvalid;
+  return view->get(BlockCoords::toIndex(BlockIndex(x), BlockIndex(y), BlockIndex(z)));
+}
+
+Chunk::row_t ChunkSnapshot::opaqueRow(int y, int z) const {
+  using row_t = Chunk::row_t;
+  EXPECTS(y >= -1 && y <= Chunk::kSizeY);
+
+  const clear_rows_t* rows = &mClearRows;
+  if(z < 0 || z >= Chunk::kSizeZ) {
+#if CUBIC_CHUNKS
+    // straight above or below only, the diagonals are not captured
+    if(y < 0 || y >= Chunk::kSizeY) return row_t(~row_t(0));
+    rows = &mNeighborClearRows[z < 0 ? Chunk::NEIGHBOR_NEG_Z : Chunk::NEIGHBOR_POS_Z];
+    z = z < 0 ? z + Chunk::kSizeZ : z - Chunk::kSizeZ;
+#else
+    return row_t(~row_t(0));
+#endif
+  }
+
+  if(y < 0) {
+    rows = &mNeighborClearRows[Chunk::NEIGHBOR_NEG_Y];
+    y += Chunk::kSizeY;
+  } else if(y >= Chunk::kSizeY) {
+    rows = &mNeighborClearRows[Chunk::NEIGHBOR_POS_Y];
+    y -= Chunk::kSizeY;
+  }
+  return row_t(~(*rows)[y | (z << Chunk::kSizeBitY)]);
+}
+
+Chunk::row_ext_t ChunkSnapshot::opaqueRowExtended(int y, int z) const {
+  using row_ext_t = Chunk::row_ext_t;
+  EXPECTS(y >= 0 && y < Chunk::kSizeY);
+
+  row_ext_t row = row_ext_t(opaqueRow(y, z) & Chunk::Layout::kRowMask) << 1;
+  if(z < 0 || z >= Chunk::kSizeZ) return row | row_ext_t(1) | (row_ext_t(1) << (Chunk::kSizeX + 1));
+
+  uint index = uint(y) | (uint(z) << Chunk::kSizeBitY);
+  row |= row_ext_t(~mNeighborClearRows[Chunk::NEIGHBOR_NEG_X][index] >> (Chunk::kSizeX - 1)) & 1u;
+  row |= (row_ext_t(~mNeighborClearRows[Chunk::NEIGHBOR_POS_X][index]) & 1u) << (Chunk::kSizeX + 1);
+  return row;
+}
+
+ChunkSnapshot::layer_t ChunkSnapshot::opaqueLayer(int z) const {
+  layer_t layer = {};
+  for(uint y = 0; y < Chunk::kSizeY; y++) {
+    uint64_t row = uint64_t(opaqueRow(int(y), z) & Chunk::Layout::kRowMask);
+    layer[y / kLayerRowsPerWord] |= row << ((y % kLayerRowsPerWord) * Chunk::kSizeX);
+  }
+  return layer;
+}
+
+void ChunkSnapshot::exposedFaces(int z, layer_t faces[6]) const {
+  EXPECTS(z >= 0 && z < Chunk::kSizeZ);
+  constexpr uint kSizeX = Chunk::kSizeX;
+  constexpr uint kLastRowShift = (kLayerRowsPerWord - 1) * kSizeX;
+
+  // bit 0 and bit kSizeX - 1 of every row in a word
+  constexpr uint64_t kRowLowBits = ~0ull / ((1ull << kSizeX) - 1ull);
+  constexpr uint64_t kRowHighBits = kRowLowBits << (kSizeX - 1);
+
+  layer_t center = opaqueLayer(z);
+  layer_t below = opaqueLayer(z - 1);
+  layer_t above = opaqueLayer(z + 1);
+
+  // the x neighbors' adjacent blocks, already where the shifted rows leave them out
+  layer_t edgeNegX = {}, edgePosX = {};
+  const Chunk::row_t* negX = &mNeighborClearRows[Chunk::NEIGHBOR_NEG_X][z << Chunk::kSizeBitY];
+  const Chunk::row_t* posX = &mNeighborClearRows[Chunk::NEIGHBOR_POS_X][z << Chunk::kSizeBitY];
+  for(uint y = 0; y < Chunk::kSizeY; y++) {
+    uint shift = (y % kLayerRowsPerWord) * kSizeX;
+    edgeNegX[y / kLayerRowsPerWord] |= uint64_t((~negX[y] >> (kSizeX - 1)) & 1u) << shift;
+    edgePosX[y / kLayerRowsPerWord] |= uint64_t(~posX[y] & 1u) << (shift + kSizeX - 1);
+  }
+  uint64_t rowNegY = uint64_t(opaqueRow(-1, z) & Chunk::Layout::kRowMask);
+  uint64_t rowPosY = uint64_t(opaqueRow(Chunk::kSizeY, z) & Chunk::Layout::kRowMask);
+
+  // opacity of the neighbor on each side moved onto the block, then the faces are where it is not opaque
+  for(uint w = 0; w < kLayerWordCount; w++) {
+    uint64_t prev = w > 0 ? center[w - 1] >> kLastRowShift : rowNegY;
+    uint64_t next = w + 1 < kLayerWordCount ? center[w + 1] & Chunk::Layout::kRowMask : rowPosY;
+
+    faces[0][w] = ~(((center[w] >> 1) & ~kRowHighBits) | edgePosX[w]);
+    faces[1][w] = ~(((center[w] << 1) & ~kRowLowBits) | edgeNegX[w]);
+    faces[2][w] = ~((center[w] << kSizeX) | prev);
+    faces[3][w] = ~((center[w] >> kSizeX) | (next << kLastRowShift));
+    faces[4][w] = ~below[w];
+    faces[5][w] = ~above[w];
+  }
+}
+
+bool ChunkSnapshot::sectionHidden(uint section) const {
+  if(!mCenter.uniform(section)) return false;
+
+  // air does not emit faces at all
+  const Block& block = mCenter.uniformBlock(section);
+  if(block.id() == 0) return true;
+  if(!block.opaque()) return false;
+
+  // out of the chunk reads as opaque
+  auto solid = [](const View* view, int s) {
+    if(view == nullptr || s < 0 || s >= int(Chunk::kSectionCount)) return true;
+    return view->uniform(s) && view->uniformBlock(s).opaque();
+  };
+
+  const View* below = &mCenter;
+  const View* above = &mCenter;
+  int belowSection = int(section) - 1;
+  int aboveSection = int(section) + 1;
+#if CUBIC_CHUNKS
+  if(belowSection < 0) {
+    below = neighbor(Chunk::NEIGHBOR_NEG_Z);
+    belowSection += int(Chunk::kSectionCount);
+  }
+  if(aboveSection >= int(Chunk::kSectionCount)) {
+    above = neighbor(Chunk::NEIGHBOR_POS_Z);
+    aboveSection -= int(Chunk::kSectionCount);
+  }
+#endif
+
+  if(!solid(below, belowSection) || !solid(above, aboveSection)) return false;
+  for(uint i = 0; i <= Chunk::NEIGHBOR_NEG_Y; i++) {
+    if(!solid(neighbor(Chunk::eNeighbor(i)), int(section))) return false;
+  }
+  return true;
+}
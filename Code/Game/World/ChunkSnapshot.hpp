@@ -0,0 +1,56 @@
+#pragma once
+#include "Engine/Core/common.hpp"
+#include "Game/World/Chunk.hpp"
+
+// immutable view of a chunk plus its direct neighbors, for jobs running off the main thread.
+// block sections are shared copy-on-write with the live chunks, so taking one is cheap and later edits
+// never show through. only the border blocks of the neighbors are supposed to be read.
+class ChunkSnapshot {
+  friend class PaddedChunk;
+public:
+  using View = Chunk::Storage::View;
+
+  // a z layer of opacity or face bits, the kSizeX bit rows packed back to back, row y at bit (y % kLayerRowsPerWord) * kSizeX
+  // of word y / kLayerRowsPerWord
+  static constexpr uint kLayerRowsPerWord = 64 / Chunk::kSizeX;
+  static constexpr uint kLayerWordCount = Chunk::kSizeY / kLayerRowsPerWord;
+  using layer_t = std::array<uint64_t, kLayerWordCount>;
+  static_assert(Chunk::kSizeX <= 32 && Chunk::kSizeX * Chunk::kSizeY >= 64, "a layer fills whole words with more than a row each");
+
+  // on the main thread, where the chunks are edited
+  static S<const ChunkSnapshot> capture(const Chunk& chunk);
+
+  uint version() const { return mVersion; }
+  ChunkCoords coords() const { return mCoords; }
+
+  // x, y (and z with cubic chunks) can step into the neighbors, anything not loaded or out of z range reads as `Block::kInvalid`
+  Block block(int x, int y, int z) const;
+  bool opaque(int x, int y, int z) const { return block(x, y, z).opaque(); }
+
+  // same layout as `Chunk::opaqueRow` and `Chunk::opaqueRowExtended`
+  Chunk::row_t opaqueRow(int y, int z) const;
+  Chunk::row_ext_t opaqueRowExtended(int y, int z) const;
+
+  // z can step one layer into the neighbors, same as `opaqueRow`
+  layer_t opaqueLayer(int z) const;
+  // a bit per block of layer z whose face borders a block that is not opaque, in `chunk_face_t` order.
+  // all six come out of shifting the packed layers a word at a time, nothing is looked up per block
+  void exposedFaces(int z, layer_t faces[6]) const;
+
+  // the section can not produce any face: all air, or solid and buried in solid sections
+  bool sectionHidden(uint section) const;
+
+protected:
+  const View* neighbor(Chunk::eNeighbor side) const { return mNeighborValid[side] ? &mNeighbors[side] : nullptr; }
+
+  uint mVersion = 0;
+  ChunkCoords mCoords;
+  View mCenter;
+  std::array<View, Chunk::NUM_NEIGHBOR> mNeighbors;
+  std::array<bool, Chunk::NUM_NEIGHBOR> mNeighborValid = {};
+  using clear_rows_t = std::array<Chunk::row_t, Chunk::kSizeY * Chunk::kSizeZ>;
+  clear_rows_t mClearRows;
+  // the neighbors' too, a copy is cheaper than reading their border blocks one by one later.
+  // not loaded ones have none clear, same as `Block::kInvalid` being opaque
+  std::array<clear_rows_t, Chunk::NUM_NEIGHBOR> mNeighborClearRows;
+};
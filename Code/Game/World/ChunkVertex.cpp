@@ -0,0 +1,77 @@
+#include "ChunkVertex.hpp"
+
+static const vec3 kFaceNormals[6] = {
+  {1, 0, 0},
+  {-1, 0, 0},
+  {0, -1, 0},
+  {0, 1, 0},
+  {0, 0, -1},
+  {0, 0, 1}
+};
+
+static const vec3 kFaceTangents[6] = {
+  {0, 1, 0},
+  {0, 1, 0},
+  {1, 0, 0},
+  {1, 0, 0},
+  {1, 0, 0},
+  {1, 0, 0}
+};
+
+const vec3& chunk_face_t::normal(uint face) {
+  EXPECTS(face < 6);
+  return kFaceNormals[face];
+}
+
+const vec3& chunk_face_t::tangent(uint face) {
+  EXPECTS(face < 6);
+  return kFaceTangents[face];
+}
+
+ivec3 chunk_quad_t::corner(uint c) const {
+  uint n = chunk_face_t::kNormalAxis[face];
+  uint u = chunk_face_t::kAxisU[face];
+  uint v = chunk_face_t::kAxisV[face];
+  int signU = chunk_face_t::kSignU[face];
+  int signV = chunk_face_t::kSignV[face];
+
+  int p[3] = { int(x), int(y), int(z) };
+  if(chunk_face_t::kNormalSign[face] > 0) p[n] += 1;
+
+  // the first corner is on the far side of an axis the uv runs down
+  if(signU < 0) p[u] += width;
+  if(signV < 0) p[v] += height;
+  if(c == 1 || c == 2) p[u] += signU * int(width);
+  if(c == 2 || c == 3) p[v] += signV * int(height);
+
+  return { p[0], p[1], p[2] };
+}
+
+chunk_vertex_t chunk_vertex_t::pack(const ivec3& position, uint face, uint sprite, uint8_t light) {
+  EXPECTS(position.x >= 0 && uint32_t(position.x) <= kMaskX);
+  EXPECTS(position.y >= 0 && uint32_t(position.y) <= kMaskY);
+  EXPECTS(position.z >= 0 && uint32_t(position.z) <= kMaskZ);
+  EXPECTS(face < 6 && sprite <= kMaskSprite);
+
+  chunk_vertex_t vertex;
+  vertex.position = uint32_t(position.x)
+                  | (uint32_t(position.y) << CHUNK_VERTEX_SHIFT_Y)
+                  | (uint32_t(position.z) << CHUNK_VERTEX_SHIFT_Z)
+                  | (uint32_t(face) << CHUNK_VERTEX_SHIFT_FACE);
+  vertex.look = uint32_t(sprite) | (uint32_t(light) << CHUNK_VERTEX_SHIFT_LIGHT);
+  return vertex;
+}
+
+void chunk_vertex_t::pack(const chunk_quad_t& quad, chunk_vertex_t out[4]) {
+  for(uint c = 0; c < 4; c++) {
+    out[c] = pack(quad.corner(c), quad.face, quad.sprite, quad.light);
+  }
+}
+
+vec2 chunk_vertex_t::uv() const {
+  ivec3 p = unpackPosition();
+  int coords[3] = { p.x, p.y, p.z };
+  uint f = face();
+  return { float(chunk_face_t::kSignU[f] * coords[chunk_face_t::kAxisU[f]]),
+           float(chunk_face_t::kSignV[f] * coords[chunk_face_t::kAxisV[f]]) };
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "Engine/Core/common.hpp"
+#include "Engine/Math/Primitives/ivec3.hpp"
+#include "Engine/Math/Primitives/vec2.hpp"
+#include "Engine/Math/Primitives/vec3.hpp"
+#include "Game/World/Chunk.hpp"
+
+// the six block faces in mesher order +x -x -y +y -z +z. a face's uv runs along axis U and V,
+// going the sign's way from its first corner, see `chunk_quad_t::corner`
+struct chunk_face_t {
+  static constexpr uint kNormalAxis[6] = { 0, 0, 1, 1, 2, 2 };
+  static constexpr int  kNormalSign[6] = { 1, -1, -1, 1, -1, 1 };
+  static constexpr uint kAxisU[6] = { 1, 1, 0, 0, 1, 0 };
+  static constexpr int  kSignU[6] = { 1, -1, 1, -1, 1, 1 };
+  static constexpr uint kAxisV[6] = { 2, 2, 2, 2, 0, 1 };
+  static constexpr int  kSignV[6] = { 1, 1, 1, 1, 1, 1 };
+
+  static const vec3& normal(uint face);
+  static const vec3& tangent(uint face);
+};
+
+// a quad of a chunk mesh as the meshers find it, before it turns into vertices.
+// it covers `width` blocks along the face's u axis and `height` along v, starting from block (x, y, z)
+struct chunk_quad_t {
+  uint16_t x, y, z;
+  uint8_t face;
+  uint8_t width, height;
+  // of the block in front of the face, `Block::light` layout
+  uint8_t light;
+  // atlas index, `BlockDef::spriteIndex`
+  uint16_t sprite;
+
+  // chunk-local corner c, counter clockwise from where the uv is (0, 0) seen from the front
+  ivec3 corner(uint c) const;
+};
+
+// a chunk mesh vertex in 8 bytes instead of a `vertex_lit_t`, bit layout in ChunkMeshFormat.hlsli.
+// the position is chunk-local (the draw adds the chunk pivot), normal and tangent follow from the face,
+// the uv from the position along the face axes
+struct chunk_vertex_t {
+  uint32_t position = 0;
+  uint32_t look = 0;
+
+  static chunk_vertex_t pack(const ivec3& position, uint face, uint sprite, uint8_t light);
+  static void pack(const chunk_quad_t& quad, chunk_vertex_t out[4]);
+
+  ivec3 unpackPosition() const {
+    return { int(position & kMaskX), int((position >> CHUNK_VERTEX_SHIFT_Y) & kMaskY), int((position >> CHUNK_VERTEX_SHIFT_Z) & kMaskZ) };
+  }
+  uint face() const { return (position >> CHUNK_VERTEX_SHIFT_FACE) & 0x7; }
+  uint sprite() const { return look & kMaskSprite; }
+  uint8_t light() const { return uint8_t(look >> CHUNK_VERTEX_SHIFT_LIGHT); }
+  // in blocks, whole numbers at block edges like the greedy mesher's uv, so only frac(uv) is the same as theirs
+  vec2 uv() const;
+
+protected:
+  static constexpr uint32_t kMaskX = (1u << CHUNK_VERTEX_SHIFT_Y) - 1u;
+  static constexpr uint32_t kMaskY = (1u << (CHUNK_VERTEX_SHIFT_Z - CHUNK_VERTEX_SHIFT_Y)) - 1u;
+  static constexpr uint32_t kMaskZ = (1u << (CHUNK_VERTEX_SHIFT_FACE - CHUNK_VERTEX_SHIFT_Z)) - 1u;
+  static constexpr uint32_t kMaskSprite = (1u << CHUNK_VERTEX_SHIFT_LIGHT) - 1u;
+
+  // corners go one past the last block
+  static_assert(Chunk::kSizeX <= kMaskX && Chunk::kSizeY <= kMaskY && Chunk::kSizeZ <= kMaskZ, "chunk too large for the packed position");
+  static_assert(SPRITESHEET_UNIT_COUNT_X * SPRITESHEET_UNIT_COUNT_Y <= kMaskSprite + 1, "atlas too large for the packed sprite");
+};
+
+static_assert(sizeof(chunk_vertex_t) == 8);
@@ -0,0 +1,105 @@
+#include "ClimateMap.hpp"
+#include "Engine/Math/Noise/SmoothNoise.hpp"
+#include "Engine/Math/Primitives/vec2.hpp"
+#include "Game/World/BlockDef.hpp"
+#include "Game/World/TerrainDensity.hpp"
+
+static constexpr float kTemperatureScale = 800.f;
+static constexpr float kHumidityScale = 600.f;
+static constexpr uint kTemperatureStream = 4;
+static constexpr uint kHumidityStream = 5;
+
+static constexpr float kDesertTemperature = .3f;
+static constexpr float kDesertHumidity = 0.f;
+static constexpr float kTundraTemperature = -.3f;
+
+static float lerp1(float a, float b, float t) {
+  return a + (b - a) * t;
+}
+
+ClimateMap& ClimateMap::get() {
+  static ClimateMap instance;
+  return instance;
+}
+
+void ClimateMap::sampleColumns(const vec2& chunkPivot, uint seed, float* temperature, float* humidity) {
+  int blockX = int(chunkPivot.x), blockY = int(chunkPivot.y);
+  // arithmetic shift, negative coords floor into the region below
+  int regionX = blockX >> kRegionBitXY, regionY = blockY >> kRegionBitXY;
+  S<const region_t> r = region(regionX, regionY, seed);
+
+  uint localX = uint(blockX - (regionX << kRegionBitXY));
+  uint localY = uint(blockY - (regionY << kRegionBitXY));
+
+  for(uint j = 0; j < Chunk::kSizeY; j++) {
+    uint y = localY + j;
+    uint sy = y >> kSampleStepBit;
+    float ty = float(y & (kSampleStep - 1)) / float(kSampleStep);
+    for(uint i = 0; i < Chunk::kSizeX; i++) {
+      uint x = localX + i;
+      uint sx = x >> kSampleStepBit;
+      float tx = float(x & (kSampleStep - 1)) / float(kSampleStep);
+
+      uint s = sx + sy * kSampleCount;
+      uint column = i + j * Chunk::kSizeX;
+      temperature[column] = lerp1(lerp1(r->temperature[s], r->temperature[s + 1], tx),
+                                  lerp1(r->temperature[s + kSampleCount], r->temperature[s + kSampleCount + 1], tx), ty);
+      humidity[column] = lerp1(lerp1(r->humidity[s], r->humidity[s + 1], tx),
+                               lerp1(r->humidity[s + kSampleCount], r->humidity[s + kSampleCount + 1], tx), ty);
+    }
+  }
+}
+
+eBiome ClimateMap::biome(float temperature, float humidity) {
+  if(temperature < kTundraTemperature) return BIOME_TUNDRA;
+  if(temperature > kDesertTemperature && humidity < kDesertHumidity) return BIOME_DESERT;
+  return BIOME_TEMPERATE;
+}
+
+const biome_blocks_t& ClimateMap::blocks(eBiome biome) {
+  // definitions are loaded once before any chunk
+  static const biome_blocks_t table[NUM_BIOME] = {
+    { BlockDef::get("grass"), BlockDef::get("dust") },
+    { BlockDef::get("sand"), BlockDef::get("sand") },
+    { BlockDef::get("snow"), BlockDef::get("dust") },
+  };
+  return table[biome];
+}
+
+size_t ClimateMap::cachedRegionCount() const {
+  std::lock_guard<std::mutex> lock(mLock);
+  return mRegions.size();
+}
+
+S<const ClimateMap::region_t> ClimateMap::region(int regionX, int regionY, uint seed) {
+  uint64_t key = (uint64_t(uint32_t(regionX)) << 32) | uint64_t(uint32_t(regionY));
+
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    if(seed != mSeed) {
+      mRegions.clear();
+      mSeed = seed;
+    }
+    auto it = mRegions.find(key);
+    if(it != mRegions.end()) return it->second;
+  }
+
+  // outside the lock, two threads may both compute a new region, the first one in wins
+  S<region_t> r(new region_t());
+  float baseX = float(regionX << kRegionBitXY), baseY = float(regionY << kRegionBitXY);
+  uint temperatureSeed = TerrainDensity::noiseSeed(seed, kTemperatureStream);
+  uint humiditySeed = TerrainDensity::noiseSeed(seed, kHumidityStream);
+  for(uint sy = 0; sy < kSampleCount; sy++) {
+    for(uint sx = 0; sx < kSampleCount; sx++) {
+      float x = baseX + float(sx * kSampleStep), y = baseY + float(sy * kSampleStep);
+      r->temperature[sx + sy * kSampleCount] = Compute2dPerlinNoise(x, y, kTemperatureScale, 2, .5f, 2.f, true, temperatureSeed);
+      r->humidity[sx + sy * kSampleCount] = Compute2dPerlinNoise(x, y, kHumidityScale, 2, .5f, 2.f, true, humiditySeed);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mLock);
+  if(seed != mSeed) return r;
+  // the streamed area moves on, dropping everything at once is simpler than tracking use and cheap to refill
+  if(mRegions.size() >= kMaxCachedRegions) mRegions.clear();
+  return mRegions.emplace(key, r).first->second;
+}
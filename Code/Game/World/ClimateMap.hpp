@@ -0,0 +1,58 @@
+#pragma once
+#include "Engine/Core/common.hpp"
+#include <mutex>
+#include <unordered_map>
+#include "Game/World/Chunk.hpp"
+
+class BlockDef;
+
+enum eBiome: uint8_t {
+  BIOME_TEMPERATE,
+  BIOME_DESERT,
+  BIOME_TUNDRA,
+  NUM_BIOME,
+};
+
+// what a biome puts on the ground: one `top` block, then `filler` down to the stone
+struct biome_blocks_t {
+  const BlockDef* top = nullptr;
+  const BlockDef* filler = nullptr;
+};
+
+// temperature and humidity in [-1, 1], sampled every kSampleStep blocks over regions of kRegionSize blocks
+// and bilinearly upsampled to the columns. a region is computed once and cached by its coords, every chunk
+// in it only interpolates. thread safe, chunks are generated on the job system
+class ClimateMap {
+public:
+  static constexpr uint kRegionBitXY = 7;
+  static constexpr uint kSampleStepBit = 3;
+  static constexpr uint kRegionSize = 1u << kRegionBitXY;
+  static constexpr uint kSampleStep = 1u << kSampleStepBit;
+  // one more than the steps, the last row and column are the first of the next region
+  static constexpr uint kSampleCount = (kRegionSize >> kSampleStepBit) + 1;
+  static constexpr uint kMaxCachedRegions = 256;
+
+  static_assert(kRegionSize % Chunk::kSizeX == 0 && kRegionSize % Chunk::kSizeY == 0, "a chunk is always in one region");
+
+  static ClimateMap& get();
+
+  // climate of every column of the chunk with its pivot at `chunkPivot`, x fastest
+  void sampleColumns(const vec2& chunkPivot, uint seed, float* temperature, float* humidity);
+
+  static eBiome biome(float temperature, float humidity);
+  static const biome_blocks_t& blocks(eBiome biome);
+
+  size_t cachedRegionCount() const;
+
+protected:
+  struct region_t {
+    float temperature[kSampleCount * kSampleCount];
+    float humidity[kSampleCount * kSampleCount];
+  };
+
+  S<const region_t> region(int regionX, int regionY, uint seed);
+
+  mutable std::mutex mLock;
+  uint mSeed = 0;
+  std::unordered_map<uint64_t, S<const region_t>> mRegions;
+};
@@ -20,7 +20,7 @@ void GPUVolume::init(uint tileCountX, uint tileCountY, eTextureFormat format) {
 
 	mTileCountX = tileCountX;
 	mTileCountY = tileCountY;
-  mPlayerTileIndex = { kTileSizeX >> 1, kTileSizeY >> 1 }; // player is alway at the center
+  mPlayerTileIndex = { tileCountX >> 1, tileCountY >> 1 }; // player is alway at the center
 }
 
 void GPUVolume::update(vec3 playerPosition) {
@@ -120,14 +120,14 @@ void GPUVolume::update(vec3 playerPosition) {
 	ctx->setComputeState(*cs);
 	inst->apply(*ctx, false);
 
-	ctx->dispatch(16, 16, 1);
+	ctx->dispatch(mTileCountX, mTileCountY, 1);
 
 	updateSubVolumeAndMipmapsDetail();
 	updateSubVolumeAndMipmapsRough();
 }
 
 uvec3 GPUVolume::voxelIndexOffset(uint tileIndexX, uint tileIndexY) {
-	if( kTileSizeX * tileIndexX >= 256 || kTileSizeY * tileIndexY >= 256) {
+	if( tileIndexX >= mTileCountX || tileIndexY >= mTileCountY) {
 		BAD_CODE_PATH();
 	}
 	return { kTileSizeX * tileIndexX, kTileSizeY * tileIndexY, 0 };
@@ -163,7 +163,7 @@ void GPUVolume::updateSubVolumeAndMipmapsDetail() const {
 	ctx->setComputeState(*cs);
 	inst->apply(*ctx, false);
 
-	ctx->dispatch(32, 32, 32);
+	ctx->dispatch(mVolume->width() / 8, mVolume->height() / 8, mVolume->depth() / 8);
 }
 
 void GPUVolume::updateSubVolumeAndMipmapsRough() const {
@@ -184,7 +184,9 @@ void GPUVolume::updateSubVolumeAndMipmapsRough() const {
 	ctx->setComputeState(*cs);
 
 	uint startMip = 2;
-	for(uint dim = 32; dim > 0; dim = dim >> 1){
+	// mip 3 and down, a flat volume (short chunks) keeps at least one group along z
+	uint dimX = mVolume->width() >> 3, dimY = mVolume->height() >> 3, dimZ = mVolume->depth() >> 3;
+	for(uint dim = std::max({ dimX, dimY, dimZ }); dim > 0; dim = dim >> 1){
 		ProgramInst::sptr_t inst = ComputeProgramInst::create(prog);
 
 		inst->setUav(*mVisibilityVolume->uav(startMip), 0, 0);
@@ -192,7 +194,8 @@ void GPUVolume::updateSubVolumeAndMipmapsRough() const {
 
 		inst->apply(*ctx, false);
 		ctx->uavBarrier(mVisibilityVolume.get());
-		ctx->dispatch(dim, dim, dim);
+		ctx->dispatch(std::max(dimX, 1u), std::max(dimY, 1u), std::max(dimZ, 1u));
+		dimX >>= 1; dimY >>= 1; dimZ >>= 1;
 	}
 }
 
@@ -10,6 +10,12 @@ public:
   static constexpr BlockIndex kTileSizeY = Chunk::kSizeY;
   static constexpr BlockIndex kTileSizeZ = Chunk::kSizeZ;
 
+  // one chunk per tile, as many as it takes to cover VOLUME_SIZE_XY blocks. see ChunkDims.hlsli
+  static constexpr uint kTileCountX = VOLUME_TILE_COUNT_X;
+  static constexpr uint kTileCountY = VOLUME_TILE_COUNT_Y;
+  static_assert(kTileCountX * kTileCountY <= 256, "VolumeUpdate binds at most 256 chunk volumes");
+  static_assert(kTileSizeY % 4 == 0 && kTileSizeZ % 4 == 0, "VolumeUpdate copies 4x4 blocks per thread");
+
   GPUVolume() {}
 
   void init(uint tileCountX, uint tileCountY, eTextureFormat format);
@@ -0,0 +1,43 @@
+#include "MesherPool.hpp"
+
+MesherPool& MesherPool::get() {
+  static MesherPool instance;
+  return instance;
+}
+
+MesherPool::~MesherPool() {
+  for(Mesher* mesher: mAvailable) {
+    delete mesher;
+  }
+}
+
+owner<Mesher*> MesherPool::acquire() {
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    if(!mAvailable.empty()) {
+      Mesher* mesher = mAvailable.back();
+      mAvailable.pop_back();
+      return mesher;
+    }
+  }
+  return new Mesher();
+}
+
+void MesherPool::release(owner<Mesher*> mesher) {
+  if(mesher == nullptr) return;
+  mesher->clear();
+
+  {
+    std::lock_guard<std::mutex> lock(mLock);
+    if(mAvailable.size() < kMaxPooled) {
+      mAvailable.push_back(mesher);
+      return;
+    }
+  }
+  delete mesher;
+}
+
+size_t MesherPool::pooledCount() const {
+  std::lock_guard<std::mutex> lock(mLock);
+  return mAvailable.size();
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "Engine/Core/common.hpp"
+#include <mutex>
+#include "Engine/Graphics/Model/Mesher.hpp"
+
+// scratch meshers for the mesh jobs. a job takes one per section it builds on a worker and hands it back on
+// the main thread once the gpu mesh is made, so no chunk keeps cpu vertices around between builds.
+// at most kMaxPooled are kept with their capacity, the rest are freed
+class MesherPool {
+public:
+  static constexpr size_t kMaxPooled = 64;
+
+  static MesherPool& get();
+
+  MesherPool() = default;
+  MesherPool(const MesherPool&) = delete;
+  MesherPool& operator=(const MesherPool&) = delete;
+  ~MesherPool();
+
+  owner<Mesher*> acquire();
+  // null is ignored
+  void release(owner<Mesher*> mesher);
+
+  size_t pooledCount() const;
+
+protected:
+  mutable std::mutex mLock;
+  std::vector<Mesher*> mAvailable;
+};
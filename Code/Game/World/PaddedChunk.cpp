@@ -0,0 +1,72 @@
+#include "PaddedChunk.hpp"
+#include "Game/World/ChunkSnapshot.hpp"
+
+void PaddedChunk::gather(const ChunkSnapshot& snapshot, uint32_t sections) {
+  // a section needs its own layers plus the one over and under it, neighboring sections share those
+  int lastLayer = -2;
+  for(uint s = 0; s < Chunk::kSectionCount; s++) {
+    if((sections & (1u << s)) == 0) continue;
+    int bottom = int(s * Chunk::kSectionSizeZ) - 1;
+    int top = int((s + 1) * Chunk::kSectionSizeZ);
+    for(int z = std::max(bottom, lastLayer + 1); z <= top; z++) {
+      gatherLayer(snapshot, z);
+    }
+    lastLayer = top;
+  }
+}
+
+void PaddedChunk::gatherLayer(const ChunkSnapshot& snapshot, int z) {
+  using View = ChunkSnapshot::View;
+  Block* layer = &mBlocks[index(-1, -1, z)];
+  std::fill_n(layer, kStrideZ, Block::kInvalid);
+
+#if CUBIC_CHUNKS
+  // the apron under and over the chunk, one face of each z neighbor
+  if(z < 0 || z >= int(Chunk::kSizeZ)) {
+    const View* neighbor = snapshot.neighbor(z < 0 ? Chunk::NEIGHBOR_NEG_Z : Chunk::NEIGHBOR_POS_Z);
+    if(neighbor == nullptr) return;
+    BlockIndex from = z < 0 ? Chunk::kSizeZ - 1 : 0;
+    for(BlockIndex y = 0; y < Chunk::kSizeY; y++) {
+      for(BlockIndex x = 0; x < Chunk::kSizeX; x++) {
+        mBlocks[index(x, y, z)] = neighbor->get(BlockCoords::toIndex(x, y, from));
+      }
+    }
+    return;
+  }
+#else
+  if(z < 0 || z >= int(Chunk::kSizeZ)) return;
+#endif
+
+  // the chunk itself, a uniform section is a plain fill
+  const View& center = snapshot.mCenter;
+  uint s = uint(z) / Chunk::kSectionSizeZ;
+  bool uniform = center.uniform(s);
+  for(int y = 0; y < int(Chunk::kSizeY); y++) {
+    Block* row = &mBlocks[index(0, y, z)];
+    if(uniform) {
+      std::fill_n(row, Chunk::kSizeX, center.uniformBlock(s));
+      continue;
+    }
+    for(int x = 0; x < int(Chunk::kSizeX); x++) {
+      row[x] = center.get(BlockCoords::toIndex(BlockIndex(x), BlockIndex(y), BlockIndex(z)));
+    }
+  }
+
+  // the apron, one face of each neighbor
+  constexpr BlockIndex kMaxX = Chunk::kSizeX - 1;
+  constexpr BlockIndex kMaxY = Chunk::kSizeY - 1;
+  const View* negX = snapshot.neighbor(Chunk::NEIGHBOR_NEG_X);
+  const View* posX = snapshot.neighbor(Chunk::NEIGHBOR_POS_X);
+  const View* negY = snapshot.neighbor(Chunk::NEIGHBOR_NEG_Y);
+  const View* posY = snapshot.neighbor(Chunk::NEIGHBOR_POS_Y);
+
+  BlockIndex k = BlockIndex(z);
+  for(BlockIndex y = 0; y < Chunk::kSizeY; y++) {
+    if(negX) mBlocks[index(-1, y, z)] = negX->get(BlockCoords::toIndex(kMaxX, y, k));
+    if(posX) mBlocks[index(Chunk::kSizeX, y, z)] = posX->get(BlockCoords::toIndex(0, y, k));
+  }
+  for(BlockIndex x = 0; x < Chunk::kSizeX; x++) {
+    if(negY) mBlocks[index(x, -1, z)] = negY->get(BlockCoords::toIndex(x, kMaxY, k));
+    if(posY) mBlocks[index(x, Chunk::kSizeY, z)] = posY->get(BlockCoords::toIndex(x, 0, k));
+  }
+}
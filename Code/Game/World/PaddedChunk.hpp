@@ -0,0 +1,37 @@
+#pragma once
+#include "Engine/Core/common.hpp"
+#include "Game/World/Chunk.hpp"
+
+class ChunkSnapshot;
+
+// a chunk plus a one block apron from its direct neighbors, copied into one flat array.
+// kernels reach any neighbor with a constant offset instead of crossing chunks through `BlockIter`.
+// the apron edges and corners (diagonal neighbors) are not captured and read as `Block::kInvalid`
+class PaddedChunk {
+public:
+  static constexpr int kSizeX = int(Chunk::kSizeX) + 2;
+  static constexpr int kSizeY = int(Chunk::kSizeY) + 2;
+  static constexpr int kSizeZ = int(Chunk::kSizeZ) + 2;
+  static constexpr int kStrideY = kSizeX;
+  static constexpr int kStrideZ = kSizeX * kSizeY;
+  static constexpr size_t kTotalBlockCount = size_t(kSizeX) * size_t(kSizeY) * size_t(kSizeZ);
+
+  // same face order as `chunk_face_t`: +x -x -y +y -z +z
+  static constexpr int kFaceOffsets[6] = { 1, -1, -kStrideY, kStrideY, -kStrideZ, kStrideZ };
+
+  PaddedChunk(): mBlocks(kTotalBlockCount) {}
+
+  // x, y, z are chunk block coords, -1 and kSize* land in the apron
+  static constexpr int index(int x, int y, int z) { return (x + 1) + (y + 1) * kStrideY + (z + 1) * kStrideZ; }
+
+  // only the layers of `sections` and the one on either side of each, the rest keeps what it had
+  void gather(const ChunkSnapshot& snapshot, uint32_t sections = Chunk::kAllSections);
+
+  const Block& operator[](int index) const { return mBlocks[index]; }
+  const Block& at(int x, int y, int z) const { return mBlocks[index(x, y, z)]; }
+
+protected:
+  void gatherLayer(const ChunkSnapshot& snapshot, int z);
+
+  std::vector<Block> mBlocks;
+};
@@ -0,0 +1,53 @@
+#include "PendingEdits.hpp"
+#include <algorithm>
+
+PendingEdits& PendingEdits::get() {
+  static PendingEdits instance;
+  return instance;
+}
+
+uint8_t PendingEdits::sourceSlot(const ChunkCoords& target, const ChunkCoords& source) {
+  chunk_coords_t d = source - target;
+#if CUBIC_CHUNKS
+  EXPECTS(d.x >= -1 && d.x <= 1 && d.y >= -1 && d.y <= 1 && d.z >= -1 && d.z <= 1);
+  return uint8_t((d.x + 1) + 3 * (d.y + 1) + 9 * (d.z + 1));
+#else
+  EXPECTS(d.x >= -1 && d.x <= 1 && d.y >= -1 && d.y <= 1);
+  return uint8_t((d.x + 1) + 3 * (d.y + 1));
+#endif
+}
+
+void PendingEdits::push(span<const routed_edit_t> edits) {
+  if(edits.size() == 0) return;
+
+  std::lock_guard<std::mutex> lock(mLock);
+  for(const routed_edit_t& e: edits) {
+    mEdits[e.target].push_back(e.edit);
+  }
+}
+
+std::vector<block_edit_t> PendingEdits::take(const ChunkCoords& target) {
+  std::lock_guard<std::mutex> lock(mLock);
+  auto iter = mEdits.find(target);
+  if(iter == mEdits.end()) return {};
+
+  std::vector<block_edit_t> edits = std::move(iter->second);
+  mEdits.erase(iter);
+
+  // pushed in whatever order the writers ran. sorted, the lower id is the one that lands where two
+  // edits meet on a block (wood before leaves in Blocks.xml), however the jobs were scheduled
+  std::sort(edits.begin(), edits.end(), [](const block_edit_t& a, const block_edit_t& b) {
+    return a.index != b.index ? a.index < b.index : a.id < b.id;
+  });
+  return edits;
+}
+
+bool PendingEdits::empty() const {
+  std::lock_guard<std::mutex> lock(mLock);
+  return mEdits.empty();
+}
+
+size_t PendingEdits::targetCount() const {
+  std::lock_guard<std::mutex> lock(mLock);
+  return mEdits.size();
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "Engine/Core/common.hpp"
+#include <mutex>
+#include <unordered_map>
+#include "Game/World/Chunk.hpp"
+
+// one block write into a chunk, by index in that chunk. `source` is where the writer sits around it, see `sourceSlot`
+struct block_edit_t {
+  BlockIndex index;
+  block_id_t id;
+  uint8_t source = 0;
+};
+
+struct routed_edit_t {
+  ChunkCoords target;
+  block_edit_t edit;
+};
+
+// block writes a generating chunk makes past its own borders (tree crowns etc.), parked by the coords of the
+// chunk they land in until that chunk is generated, loaded, or found already loaded when the writer registers.
+// generation stays chunk-local: no neighbor has to exist and no chunk is locked, only this store.
+// edits only fill blocks that are not opaque, features never carve into terrain or into each other.
+// kept in memory only. a chunk saves the edits it made past its borders and pushes them again when it is loaded,
+// see `Chunk::serialize`, so a neighbor generated in a later session gets them all the same
+class PendingEdits {
+public:
+  static PendingEdits& get();
+
+  // the writer's place in the 3x3 (3x3x3) chunks around the target, the bit it takes in `Chunk::mFedBy`
+  static uint8_t sourceSlot(const ChunkCoords& target, const ChunkCoords& source);
+
+  void push(span<const routed_edit_t> edits);
+  // moves every edit parked for `target` out of the store, sorted by block index then id.
+  // applied in that order the outcome of edits meeting on a block does not depend on who pushed first
+  std::vector<block_edit_t> take(const ChunkCoords& target);
+
+  bool empty() const;
+  size_t targetCount() const;
+
+protected:
+  mutable std::mutex mLock;
+  std::unordered_map<ChunkCoords, std::vector<block_edit_t>> mEdits;
+};
@@ -0,0 +1,153 @@
+#include "TerrainDensity.hpp"
+#include <limits>
+#include "Engine/Math/Noise/SmoothNoise.hpp"
+#include "Engine/Math/Noise/RawNoise.hpp"
+#include "Game/World/BlockDef.hpp"
+
+static constexpr float kGroundNoiseScale = 48.f;
+static constexpr float kCaveNoiseScale = 32.f;
+static constexpr uint kGroundNoiseStream = 1;
+static constexpr uint kCaveNoiseStream = 2;
+static constexpr uint kOreStream = 3;
+
+static float lerp1(float a, float b, float t) {
+  return a + (b - a) * t;
+}
+
+TerrainDensity::TerrainDensity(const vec3& chunkPivot, const float* heights, const eBiome* biomes, uint worldSeed)
+  : mPivot(chunkPivot)
+  , mHeights(heights)
+  , mBiomes(biomes)
+  , mSeed(worldSeed)
+  , mMinHeight(std::numeric_limits<float>::max())
+  , mMaxHeight(std::numeric_limits<float>::lowest()) {
+  for(uint i = 0; i < Chunk::kSizeX * Chunk::kSizeY; i++) {
+    mMinHeight = std::min(mMinHeight, heights[i]);
+    mMaxHeight = std::max(mMaxHeight, heights[i]);
+  }
+}
+
+TerrainDensity::eSectionFill TerrainDensity::classify(uint section) const {
+  int bottom = int(section * Chunk::kSectionSizeZ);
+  int top = bottom + int(Chunk::kSectionSizeZ) - 1;
+
+  // noise never moves the ground further than kSurfaceNoiseRange, caves only remove blocks
+  if(float(bottom) > mMaxHeight + kSurfaceNoiseRange) return SECTION_AIR;
+
+  // below the cave band the ground and the kSurfaceLayers blocks over it are solid for sure
+  float solidBelow = mMinHeight - std::max(kSurfaceNoiseRange, kCaveDepthRange);
+  ore_pocket_t pocket;
+  if(float(top + kSurfaceLayers) < solidBelow && !orePocket(section, pocket)) return SECTION_STONE;
+
+  return SECTION_MIXED;
+}
+
+void TerrainDensity::fillSection(uint section, block_id_t* ids, uint8_t* flags) const {
+  static BlockDef* const air = BlockDef::get("air");
+  static BlockDef* const stone = BlockDef::get("stone");
+  static BlockDef* const ore = BlockDef::get("ore");
+
+  int bottom = int(section * Chunk::kSectionSizeZ);
+  int top = bottom + int(Chunk::kSectionSizeZ) - 1;
+  BlockIndex base = BlockIndex(section * Chunk::kSectionBlockCount);
+
+  // each noise is only sampled when the section reaches into the band it can change, zero elsewhere
+  float ground[kLatticePointCount] = {};
+  float caves[kLatticePointCount] = {};
+  if(float(top + kSurfaceLayers) >= mMinHeight - kSurfaceNoiseRange) {
+    sampleLattice(ground, bottom, kGroundNoiseScale, noiseSeed(mSeed, kGroundNoiseStream));
+  }
+  if(float(top) >= mMinHeight - kCaveDepthRange && float(bottom) <= mMaxHeight - kCaveMinDepth) {
+    sampleLattice(caves, bottom, kCaveNoiseScale, noiseSeed(mSeed, kCaveNoiseStream));
+  }
+
+  ore_pocket_t pocket;
+  bool hasOre = orePocket(section, pocket);
+  int oreRange2 = pocket.radius * pocket.radius + pocket.radius;
+
+  float groundColumn[kLatticeSizeZ];
+  float caveColumn[kLatticeSizeZ];
+
+  for(uint j = 0; j < Chunk::kSizeY; j++) {
+    for(uint i = 0; i < Chunk::kSizeX; i++) {
+      // bilinear in the lattice cell once per column, the z lerp is left per block
+      uint cx = i / kCellSizeXY, cy = j / kCellSizeXY;
+      float tx = float(i % kCellSizeXY) / float(kCellSizeXY);
+      float ty = float(j % kCellSizeXY) / float(kCellSizeXY);
+      for(uint cz = 0; cz < kLatticeSizeZ; cz++) {
+        uint p = cx + cy * kLatticeSizeX + cz * kLatticeSizeX * kLatticeSizeY;
+        groundColumn[cz] = lerp1(lerp1(ground[p], ground[p + 1], tx),
+                                 lerp1(ground[p + kLatticeSizeX], ground[p + kLatticeSizeX + 1], tx), ty);
+        caveColumn[cz] = lerp1(lerp1(caves[p], caves[p + 1], tx),
+                               lerp1(caves[p + kLatticeSizeX], caves[p + kLatticeSizeX + 1], tx), ty);
+      }
+
+      float height = mHeights[i + j * Chunk::kSizeX];
+      const biome_blocks_t& surface = ClimateMap::blocks(mBiomes[i + j * Chunk::kSizeX]);
+
+      // top down from kSurfaceLayers above the section, `depth` is how many solid blocks are right above,
+      // it saturates at kSurfaceLayers so starting there is enough to know it for every block of the section
+      int depth = 0;
+      for(int k = top + kSurfaceLayers; k >= bottom; k--) {
+        uint local = uint(k - bottom);
+        uint cz = local / kCellSizeZ;
+        float tz = float(local % kCellSizeZ) / float(kCellSizeZ);
+        float underground = height - float(k);
+
+        bool solid = underground / kSurfaceNoiseRange + lerp1(groundColumn[cz], groundColumn[cz + 1], tz) >= 0.f;
+
+        if(k <= top) {
+          const BlockDef* def = air;
+          if(solid) {
+            def = depth == 0 ? surface.top : (depth < kSurfaceLayers ? surface.filler : stone);
+
+            bool inCaveBand = underground >= kCaveMinDepth && underground <= kCaveDepthRange;
+            if(inCaveBand && lerp1(caveColumn[cz], caveColumn[cz + 1], tz) > kCaveThreshold) {
+              def = air;
+            } else if(hasOre && def == stone) {
+              int dx = int(i) - pocket.x, dy = int(j) - pocket.y, dz = int(local) - pocket.z;
+              if(dx * dx + dy * dy + dz * dz <= oreRange2) def = ore;
+            }
+          }
+
+          BlockIndex m = BlockCoords::toIndex(BlockIndex(i), BlockIndex(j), BlockIndex(k)) - base;
+          ids[m] = def->id();
+          flags[m] = def->opaque() ? Block::kOpaqueFlag : 0x0;
+        }
+
+        depth = solid ? std::min(depth + 1, kSurfaceLayers) : 0;
+      }
+    }
+  }
+}
+
+// one pocket in about every fourth section, placed by hashing the section's world position so neighbors
+// and reloads agree. it stays inside the section, pockets never have to be split across chunks
+bool TerrainDensity::orePocket(uint section, ore_pocket_t& pocket) const {
+  int chunkX = int(mPivot.x) / int(Chunk::kSizeX);
+  int chunkY = int(mPivot.y) / int(Chunk::kSizeY);
+  int sectionZ = int(mPivot.z) / int(Chunk::kSectionSizeZ) + int(section);
+
+  uint hash = Get3dNoiseUint(chunkX, chunkY, sectionZ, noiseSeed(mSeed, kOreStream));
+  pocket.radius = 1 + int((hash >> 2) & 0x1);
+  if((hash & 0x3) != 0) return false;
+
+  int r = pocket.radius;
+  pocket.x = r + int((hash >> 8) % (Chunk::kSizeX - 2 * r));
+  pocket.y = r + int((hash >> 16) % (Chunk::kSizeY - 2 * r));
+  pocket.z = r + int((hash >> 24) % (Chunk::kSectionSizeZ - 2 * r));
+  return true;
+}
+
+void TerrainDensity::sampleLattice(float* lattice, int sectionBottom, float scale, uint seed) const {
+  for(uint z = 0; z < kLatticeSizeZ; z++) {
+    float worldZ = mPivot.z + float(sectionBottom + int(z * kCellSizeZ));
+    for(uint y = 0; y < kLatticeSizeY; y++) {
+      float worldY = mPivot.y + float(y * kCellSizeXY);
+      for(uint x = 0; x < kLatticeSizeX; x++) {
+        float worldX = mPivot.x + float(x * kCellSizeXY);
+        *lattice++ = Compute3dPerlinNoise(worldX, worldY, worldZ, scale, 2, .5f, 2.f, true, seed);
+      }
+    }
+  }
+}
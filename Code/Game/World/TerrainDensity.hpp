@@ -0,0 +1,76 @@
+#pragma once
+#include "Engine/Core/common.hpp"
+#include "Game/World/Chunk.hpp"
+#include "Game/World/ClimateMap.hpp"
+
+// which stage turns the 2d surface heights of `Chunk::generateBlocks` into blocks:
+// HEIGHTMAP: every column is stone | filler | top | air split at its surface height
+// DENSITY: 3d density around the surface, overhangs, caves and ore pockets, see `TerrainDensity`
+// either way the surface blocks come from the column biome, see `ClimateMap`
+// the mode is written into every chunk save, saves from the other one are generated again
+#define TERRAIN_GENERATOR_HEIGHTMAP 0
+#define TERRAIN_GENERATOR_DENSITY   1
+
+#ifndef TERRAIN_GENERATOR_MODE
+#define TERRAIN_GENERATOR_MODE TERRAIN_GENERATOR_HEIGHTMAP
+#endif
+
+class BlockDef;
+
+// the density stage for one chunk. ground is solid where (surface - z) / kSurfaceNoiseRange + noise >= 0,
+// so the 3d noise can only move it kSurfaceNoiseRange blocks off the 2d surface. caves carve the ground
+// between kCaveMinDepth and kCaveDepthRange below the surface, ore pockets replace stone.
+// noise is evaluated on a coarse lattice per section and trilinearly interpolated in between,
+// sections the height bounds prove to be all air or all stone do not evaluate any
+class TerrainDensity {
+public:
+  static constexpr float kSurfaceNoiseRange = 12.f;
+  static constexpr float kCaveMinDepth = 5.f;
+  static constexpr float kCaveDepthRange = 48.f;
+  static constexpr float kCaveThreshold = .4f;
+  // the biome top block then its filler under the ground top, stone below
+  static constexpr int kSurfaceLayers = 3;
+
+  static constexpr uint kCellSizeXY = 4;
+  static constexpr uint kCellSizeZ = 8;
+  static constexpr uint kLatticeSizeX = Chunk::kSizeX / kCellSizeXY + 1;
+  static constexpr uint kLatticeSizeY = Chunk::kSizeY / kCellSizeXY + 1;
+  // the lattice also covers the kSurfaceLayers blocks above the section, they decide grass and dust
+  static constexpr uint kLatticeSizeZ = (Chunk::kSectionSizeZ - 1 + kSurfaceLayers) / kCellSizeZ + 2;
+  static constexpr uint kLatticePointCount = kLatticeSizeX * kLatticeSizeY * kLatticeSizeZ;
+
+  static_assert(Chunk::kSizeX % kCellSizeXY == 0 && Chunk::kSizeY % kCellSizeXY == 0);
+
+  enum eSectionFill {
+    SECTION_AIR,
+    SECTION_STONE,
+    SECTION_MIXED,
+  };
+
+  // `heights` are the surface heights relative to the chunk bottom and `biomes` pick the top and filler
+  // blocks, both per column x fastest
+  TerrainDensity(const vec3& chunkPivot, const float* heights, const eBiome* biomes, uint worldSeed);
+
+  // seed of noise `stream` (0 is the 2d surface) in world `worldSeed`, distinct for the first 2^30 world seeds
+  static uint noiseSeed(uint worldSeed, uint stream) { return worldSeed * kNoiseStreamCount + stream; }
+  static constexpr uint kNoiseStreamCount = 8;
+
+  eSectionFill classify(uint section) const;
+  void fillSection(uint section, block_id_t* ids, uint8_t* flags) const;
+
+protected:
+  struct ore_pocket_t {
+    int x, y, z;
+    int radius;
+  };
+
+  bool orePocket(uint section, ore_pocket_t& pocket) const;
+  void sampleLattice(float* lattice, int sectionBottom, float scale, uint seed) const;
+
+  vec3 mPivot;
+  const float* mHeights;
+  const eBiome* mBiomes;
+  uint mSeed;
+  float mMinHeight;
+  float mMaxHeight;
+};
@@ -1,4 +1,6 @@
 
+#include "ChunkDims.hlsli"
+
 #define VolumeUpdate_RootSig \
     "RootFlags(ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT), " \
 		"DescriptorTable(SRV(t0, numDescriptors = 256, flags = DATA_VOLATILE), UAV(u0, numDescriptors = 1), visibility = SHADER_VISIBILITY_ALL)," \
@@ -9,10 +11,11 @@ RWTexture3D<uint> uOutput: register(u0);
 
 
 [RootSignature(VolumeUpdate_RootSig)]
-[numthreads(1, 4, 64)]				// 16/16,  16/4, 256/4
+// one group per chunk, each thread copies a CHUNK_SIZE_X x 4 x 4 block of it
+[numthreads(1, CHUNK_SIZE_Y / 4, CHUNK_SIZE_Z / 4)]
 void main( uint3 localId : SV_GroupThreadID, uint3 groupId: SV_GroupId )
 {
-	uint3 baseCoords = groupId * uint3(16, 16, 256);
+	uint3 baseCoords = groupId * uint3(CHUNK_SIZE_X, CHUNK_SIZE_Y, CHUNK_SIZE_Z);
 	// 
 	// for(uint k = 0; k < 256; k++) {
 	// 	for(uint j = 0; j < 16; j++) {
@@ -28,9 +31,9 @@ void main( uint3 localId : SV_GroupThreadID, uint3 groupId: SV_GroupId )
   
   for(uint k = 0; k < 4; k++) {
   	for(uint j = 0; j < 4; j++) {
-  		for(uint i = 0; i < 16; i++) {
+  		for(uint i = 0; i < CHUNK_SIZE_X; i++) {
   			uint3 localCoords = uint3(i + offset.x, j + offset.y, k + offset.z);
-  			uint tex = gTextures[16 * groupId.y + groupId.x].Load(uint4(localCoords, 0));
+  			uint tex = gTextures[VOLUME_TILE_COUNT_X * groupId.y + groupId.x].Load(uint4(localCoords, 0));
   			uOutput[baseCoords + localCoords] = tex;
   		}
   	}
@@ -9,6 +9,7 @@
 
 #include "Game/World/Chunk.hpp"
 #include "Game/Utils/Config.hpp"
+#include "Game/World/BlockProperties.hpp"
 #include "imgui/imgui_internal.h"
 #include "Engine/Input/Input.hpp"
 #include "Engine/Math/Primitives/ray3.hpp"
@@ -16,7 +17,9 @@
 #include "Engine/Debug/Log.hpp"
 #include "Engine/Math/Noise/SmoothNoise.hpp"
 #include <stdlib.h>
+#include <algorithm>
 #include "Game/Utils/FileCache.hpp"
+#include "Game/World/PendingEdits.hpp"
 
 void World::onInit() {
 
@@ -191,6 +194,38 @@ void World::registerChunkToWorld(Chunk* chunk) {
 
   chunk->onRegisterToWorld(this);
   mActiveChunks[chunk->coords()] = chunk;
+  mChunkSlots[chunkSlot(chunk->coords())] = chunk;
+
+  flushPendingEdits(chunk->coords());
+}
+
+// a chunk only takes its pending edits when generated or loaded. edits it wrote into neighbors that were
+// already loaded, or got while it was between its generation and here, are picked up now. a neighbor that
+// has the writer's edits from before leaves them out, see `Chunk::takeNewEdits`
+void World::flushPendingEdits(const ChunkCoords& around) {
+  PendingEdits& store = PendingEdits::get();
+  if(store.empty()) return;
+
+#if CUBIC_CHUNKS
+  for(int k = -1; k <= 1; k++) {
+#else
+  {
+#endif
+    for(int j = -1; j <= 1; j++) {
+      for(int i = -1; i <= 1; i++) {
+#if CUBIC_CHUNKS
+        ChunkCoords coords = around + ChunkCoords{ ivec3{ i, j, k } };
+#else
+        ChunkCoords coords = around + ChunkCoords{ i, j };
+#endif
+        Chunk* chunk = findChunk(coords);
+        if(chunk->invalid()) continue;
+
+        std::vector<block_edit_t> edits = chunk->takeNewEdits(store);
+        if(!edits.empty()) chunk->applyLiveEdits(edits);
+      }
+    }
+  }
 }
 
 owner<Chunk*> World::unregisterChunkFromWorld(const ChunkCoords& coords) {
@@ -202,6 +237,7 @@ owner<Chunk*> World::unregisterChunkFromWorld(const ChunkCoords& coords) {
   iter->second = Chunk::invalidIter().chunk();
 
   ENSURES(chunk != nullptr);
+  if(mChunkSlots[chunkSlot(coords)] == chunk) mChunkSlots[chunkSlot(coords)] = nullptr;
   if(chunk->valid()) {
     chunk->onUnregisterFromWorld();
   }
@@ -223,6 +259,123 @@ Chunk* World::findChunk(const vec3& worldPosition) const {
 
 }
 
+uint World::chunkSlot(const ChunkCoords& coords) {
+  constexpr int kMaskXY = (1 << kChunkSlotBitXY) - 1;
+  uint slot = uint(coords.x & kMaskXY) | (uint(coords.y & kMaskXY) << kChunkSlotBitXY);
+#if CUBIC_CHUNKS
+  constexpr int kMaskZ = (1 << kChunkSlotBitZ) - 1;
+  slot |= uint(coords.z & kMaskZ) << (kChunkSlotBitXY * 2);
+#endif
+  return slot;
+}
+
+Chunk* World::cachedChunk(const ChunkCoords& coords) const {
+  // a chunk gone back to the pool has no owner any more, whatever coords it still has
+  thread_local Chunk* lastChunk = nullptr;
+  if(lastChunk != nullptr && lastChunk->world() == this && lastChunk->coords() == coords) return lastChunk;
+
+  std::atomic<Chunk*>& slot = mChunkSlots[chunkSlot(coords)];
+  Chunk* chunk = slot.load(std::memory_order_relaxed);
+  if(chunk == nullptr || chunk->world() != this || !(chunk->coords() == coords)) {
+    chunk = findChunk(coords);
+    if(chunk->invalid()) return chunk;
+    // a colliding chunk loses the slot to the one in use now
+    slot.store(chunk, std::memory_order_relaxed);
+  }
+  lastChunk = chunk;
+  return chunk;
+}
+
+Block World::block(const ivec3& worldBlock) const {
+#if !CUBIC_CHUNKS
+  if(worldBlock.z < 0 || worldBlock.z >= int(Chunk::kSizeZ)) return Block::kInvalid;
+#endif
+
+  // sizes are powers of two, shift and mask floor for negative coords as well
+#if CUBIC_CHUNKS
+  ChunkCoords coords = ivec3{ worldBlock.x >> Chunk::kSizeBitX, worldBlock.y >> Chunk::kSizeBitY, worldBlock.z >> Chunk::kSizeBitZ };
+#else
+  ChunkCoords coords = { worldBlock.x >> Chunk::kSizeBitX, worldBlock.y >> Chunk::kSizeBitY };
+#endif
+  const Chunk* chunk = cachedChunk(coords);
+  if(chunk->invalid()) return Block::kInvalid;
+
+  return chunk->block(BlockCoords::toIndex(BlockIndex(worldBlock.x & (Chunk::kSizeX - 1)), 
+                                           BlockIndex(worldBlock.y & (Chunk::kSizeY - 1)), 
+                                           BlockIndex(worldBlock.z & (Chunk::kSizeZ - 1))));
+}
+
+void World::blocks(span<const ivec3> worldBlocks, span<Block> out) const {
+  EXPECTS(out.size() >= worldBlocks.size());
+
+  // positions grouped by chunk, each chunk is resolved once and then read block after block
+  struct gather_t {
+    ChunkCoords coords;
+    BlockIndex index;
+    uint position;
+  };
+  thread_local std::vector<gather_t> gathers;
+  gathers.clear();
+
+  for(uint i = 0; i < uint(worldBlocks.size()); i++) {
+    const ivec3& p = worldBlocks[i];
+#if CUBIC_CHUNKS
+    ChunkCoords coords = ivec3{ p.x >> Chunk::kSizeBitX, p.y >> Chunk::kSizeBitY, p.z >> Chunk::kSizeBitZ };
+#else
+    if(p.z < 0 || p.z >= int(Chunk::kSizeZ)) {
+      out[i] = Block::kInvalid;
+      continue;
+    }
+    ChunkCoords coords = { p.x >> Chunk::kSizeBitX, p.y >> Chunk::kSizeBitY };
+#endif
+    BlockIndex index = BlockCoords::toIndex(BlockIndex(p.x & (Chunk::kSizeX - 1)), 
+                                            BlockIndex(p.y & (Chunk::kSizeY - 1)), 
+                                            BlockIndex(p.z & (Chunk::kSizeZ - 1)));
+    gathers.push_back({ coords, index, i });
+  }
+
+  // stable, so each chunk's blocks are still read in the order they were asked for
+  std::stable_sort(gathers.begin(), gathers.end(), [](const gather_t& a, const gather_t& b) {
+    if(a.coords.x != b.coords.x) return a.coords.x < b.coords.x;
+#if CUBIC_CHUNKS
+    if(a.coords.y != b.coords.y) return a.coords.y < b.coords.y;
+    return a.coords.z < b.coords.z;
+#else
+    return a.coords.y < b.coords.y;
+#endif
+  });
+
+  for(size_t begin = 0; begin < gathers.size();) {
+    const ChunkCoords& coords = gathers[begin].coords;
+    size_t end = begin + 1;
+    while(end < gathers.size() && gathers[end].coords == coords) end++;
+
+    const Chunk* chunk = cachedChunk(coords);
+    if(chunk->invalid()) {
+      for(size_t g = begin; g < end; g++) out[gathers[g].position] = Block::kInvalid;
+    } else {
+      for(size_t g = begin; g < end; g++) out[gathers[g].position] = chunk->block(gathers[g].index);
+    }
+    begin = end;
+  }
+}
+
+uint World::activeChunkCount() const {
+  uint count = 0;
+  for(const auto& [_, chunk]: mActiveChunks) {
+    if(chunk->valid()) count++;
+  }
+  return count;
+}
+
+size_t World::activeChunkMemory() const {
+  size_t total = 0;
+  for(const auto& [_, chunk]: mActiveChunks) {
+    if(chunk->valid()) total += chunk->memoryUsage();
+  }
+  return total;
+}
+
 raycast_result_t World::raycast(const vec3& start, const vec3& dir, float maxDist) const {
   mDebugRayCubes.clear();
 
@@ -241,6 +394,29 @@ raycast_result_t World::raycast(const vec3& start, const vec3& dir, float maxDis
 
   if(chunk->invalid()) return result;
 
+  // heading up from above the terrain of every chunk the ray can reach, nothing to hit.
+  // unloaded chunks and the top of the world stop the ray as well, those still go the long way.
+  // cubic chunks have no top of the world, the ray steps through the slabs above
+#if !CUBIC_CHUNKS
+  if(dir.z >= 0 && ray.end().z < float(Chunk::kSizeZ)) {
+    vec3 end = ray.end();
+    ChunkCoords lo = ChunkCoords::fromWorld({ std::min(start.x, end.x), std::min(start.y, end.y), 0 });
+    ChunkCoords hi = ChunkCoords::fromWorld({ std::max(start.x, end.x), std::max(start.y, end.y), 0 });
+
+    bool loaded = true;
+    float terrainTop = 0;
+    for(int y = lo.y; y <= hi.y && loaded; y++) {
+      for(int x = lo.x; x <= hi.x && loaded; x++) {
+        Chunk* c = findChunk(ChunkCoords{ x, y });
+        loaded = c->valid();
+        terrainTop = std::max(terrainTop, c->terrainBounds().maxs.z);
+      }
+    }
+
+    if(loaded && start.z >= terrainTop) return result;
+  }
+#endif
+
   // found chunk, start ray casting
 
   Chunk::BlockIter prev = chunk->blockIter(start);
@@ -299,7 +475,7 @@ raycast_result_t World::raycast(const vec3& start, const vec3& dir, float maxDis
       norm = {0, 0, -signs.z};
     }
 
-    if(prev->opaque()) {
+    if(prev.opaque()) {
       float t = std::min(dx, std::min(dy, dz));
       result.contact.block = prev;
       result.contact.position = ray.at(t);
@@ -409,6 +585,21 @@ void World::submitDirtyBlock(const Chunk::BlockIter& block) {
   mLightDirtyList.push_back(block);
 }
 
+void World::submitPlayerEdit(const Chunk::BlockIter& block) {
+  if(block.chunk->invalid()) return;
+
+  // the edit only dirtied the neighbors it borders, the rest are skipped as clean
+  auto submit = [this](const Chunk* chunk) {
+    if(chunk->invalid()) return;
+    if(std::find(mPriorityRemesh.begin(), mPriorityRemesh.end(), chunk->coords()) != mPriorityRemesh.end()) return;
+    mPriorityRemesh.push_back(chunk->coords());
+  };
+  submit(block.chunk.chunk());
+  for(uint i = 0; i < Chunk::NUM_NEIGHBOR; i++) {
+    submit(block.chunk->neighbor(Chunk::eNeighbor(i)).chunk());
+  }
+}
+
 owner<Mesh*> World::aquireDebugLightDirtyMesh() const {
   Mesher ms;
 
@@ -444,10 +635,11 @@ bool World::collide(CollisionSphere& target) const {
   vec3 centerPosition = center.centerPosition();
   EXPECTS(center.valid());
 
-  Chunk::BlockIter 
-    iterpx = center, iternx = center, 
-    iterpy = center, iterny = center, 
-    iterpz = center, iternz = center;
+  // the 3x3x3 blocks around, straight from the chunk opacity masks
+  uint32_t opaqueMask = Chunk::opaqueNeighborhood(center);
+  auto opaqueAt = [opaqueMask](int dx, int dy, int dz) {
+    return ((opaqueMask >> ((dx + 1) + (dy + 1) * 3 + (dz + 1) * 9)) & 1u) != 0;
+  };
 
   bool collided = false;
 
@@ -455,9 +647,7 @@ bool World::collide(CollisionSphere& target) const {
   {
     bool collideFirst = false;
     {
-      auto iter = center.nextPosX();
-      iterpx = iter;
-      if(iter->opaque()) {
+      if(opaqueAt(1, 0, 0)) {
         vec3 position = centerPosition + vec3{1, 0, 0};
         float ds = position.x - targetCenter.x;
         if(ds < .5f + target.radius) {
@@ -467,9 +657,7 @@ bool World::collide(CollisionSphere& target) const {
         }
       }
     } if(!collideFirst) {
-      auto iter = center.nextNegX();
-      iternx = iter;
-      if(iter->opaque()) {
+      if(opaqueAt(-1, 0, 0)) {
         vec3 position = centerPosition + vec3{-1, 0, 0};
         float ds = targetCenter.x - position.x;
         if(ds < .5f + target.radius) {
@@ -484,9 +672,7 @@ bool World::collide(CollisionSphere& target) const {
   {
     bool collideFirst = false;
     {
-      auto iter = center.nextPosY();
-      iterpy = iter;
-      if(iter->opaque()) {
+      if(opaqueAt(0, 1, 0)) {
         vec3 position = centerPosition + vec3{0, 1, 0};
         float ds = position.y - targetCenter.y;
         if(ds < .5f + target.radius) {
@@ -496,9 +682,7 @@ bool World::collide(CollisionSphere& target) const {
         }
       }
     } if(!collideFirst) {
-      auto iter = center.nextNegY();
-      iterny = iter;
-      if(iter->opaque()) {
+      if(opaqueAt(0, -1, 0)) {
         vec3 position = centerPosition + vec3{0, -1, 0};
         float ds = targetCenter.y - position.y;
         if(ds < .5f + target.radius) {
@@ -513,9 +697,7 @@ bool World::collide(CollisionSphere& target) const {
   {
     bool collideFirst = false;
     {
-      auto iter = center.nextPosZ();
-      iterpz = iter;
-      if(iter->opaque()) {
+      if(opaqueAt(0, 0, 1)) {
         vec3 position = centerPosition + vec3{0, 0, 1};
         float ds = position.z - targetCenter.z;
         if(ds < .5f + target.radius) {
@@ -525,9 +707,7 @@ bool World::collide(CollisionSphere& target) const {
         }
       }
     } if(!collideFirst) {
-      auto iter = center.nextNegZ();
-      iternz = iter;
-      if(iter->opaque()) {
+      if(opaqueAt(0, 0, -1)) {
         vec3 position = centerPosition + vec3{0, 0, -1};
         float ds = targetCenter.z - position.z;
         if(ds < .5f + target.radius) {
@@ -543,18 +723,6 @@ bool World::collide(CollisionSphere& target) const {
     return collided;
   }
 
-  Chunk::BlockIter
-    // const x
-    iterpypz = center, iterpynz = center,
-    iternypz = center, iternynz = center,
-    // const y
-    iterpxpz = center, iterpxnz = center,
-    iternxpz = center, iternxnz = center,
-    // const z
-    iternxpy = center, iternxny = center,
-    iterpxpy = center, iterpxny = center;
-
-
   /*
    *   1 - 2
    *   |   |
@@ -563,15 +731,10 @@ bool World::collide(CollisionSphere& target) const {
   
   // yz - const x
   {
-    iterpypz = iterpy.nextPosZ();
-    iternypz = iterny.nextPosZ();
-    iternynz = iterny.nextNegZ();
-    iterpynz = iterpy.nextNegZ();
-
     vec2 centeryz = centerPosition.yz();
 
     // 1, 3
-    if(iterpypz->opaque()){
+    if(opaqueAt(0, 1, 1)){
       vec2 delta = vec2{.5f, .5f};
       vec2 corner1 = centeryz + delta;
       float distance1 = targetCenter.yz().distance(corner1);
@@ -581,7 +744,7 @@ bool World::collide(CollisionSphere& target) const {
         direction = direction * ds;
         targetCenter += vec3{0, direction.x, direction.y};
         collided = true;
-      } else if(iternynz->opaque()) {
+      } else if(opaqueAt(0, -1, -1)) {
         // not collided, check the other side
         vec2 corner2 = centeryz - delta;
         float distance2 = targetCenter.yz().distance(corner2);
@@ -593,7 +756,7 @@ bool World::collide(CollisionSphere& target) const {
           collided = true;
         }
       }
-    } else if(iternynz->opaque()) {
+    } else if(opaqueAt(0, -1, -1)) {
       // not collided, check the other side
       vec2 delta = vec2{.5f, .5f};
       vec2 corner2 = centeryz - delta;
@@ -608,7 +771,7 @@ bool World::collide(CollisionSphere& target) const {
     }
 
     // 2, 4
-    if(iternypz->opaque()){
+    if(opaqueAt(0, -1, 1)){
       vec2 delta = vec2{-.5f, .5f};
       vec2 corner1 = centeryz + delta;
       float distance1 = targetCenter.yz().distance(corner1);
@@ -618,7 +781,7 @@ bool World::collide(CollisionSphere& target) const {
         direction = direction * ds;
         targetCenter += vec3{0, direction.x, direction.y};
         collided = true;
-      } else if(iterpynz->opaque()) {
+      } else if(opaqueAt(0, 1, -1)) {
         // not collided, check the other side
         vec2 corner2 = centeryz - delta;
         float distance2 = targetCenter.yz().distance(corner2);
@@ -630,7 +793,7 @@ bool World::collide(CollisionSphere& target) const {
           collided = true;
         }
       }
-    } else if(iterpynz->opaque()) {
+    } else if(opaqueAt(0, 1, -1)) {
       // not collided, check the other side
       vec2 delta = vec2{-.5f, .5f};
       vec2 corner2 = centeryz - delta;
@@ -646,15 +809,10 @@ bool World::collide(CollisionSphere& target) const {
   }
   // xz - const y
   {
-    iternxpz = iternx.nextPosZ();
-    iterpxpz = iterpx.nextPosZ();
-    iterpxnz = iterpx.nextNegZ();
-    iternxnz = iternx.nextNegZ();
-    
     vec2 centerxz = centerPosition.xz();
 
     // 1, 3
-    if(iternxpz->opaque()) {
+    if(opaqueAt(-1, 0, 1)) {
       vec2 delta = vec2{ -.5f, .5f };
       vec2 corner1 = centerxz + delta;
       float distance1 = targetCenter.xz().distance(corner1);
@@ -664,7 +822,7 @@ bool World::collide(CollisionSphere& target) const {
         direction = direction * ds;
         targetCenter += vec3{direction.x, 0, direction.y};
         collided = true;
-      } else if(iterpxnz->opaque()) {
+      } else if(opaqueAt(1, 0, -1)) {
         // not collided, check the other side
         vec2 corner2 = centerxz - delta;
         float distance2 = targetCenter.xz().distance(corner2);
@@ -676,7 +834,7 @@ bool World::collide(CollisionSphere& target) const {
           collided = true;
         }
       }
-    } else if(iterpxnz->opaque()) {
+    } else if(opaqueAt(1, 0, -1)) {
       // not collided, check the other side
       vec2 delta = vec2{-.5f, .5f};
       vec2 corner2 = centerxz - delta;
@@ -691,7 +849,7 @@ bool World::collide(CollisionSphere& target) const {
     }
 
     // 2, 4
-    if(iterpxpz->opaque()){
+    if(opaqueAt(1, 0, 1)){
       vec2 delta = vec2{.5f, .5f};
       vec2 corner1 = centerxz + delta;
       float distance1 = targetCenter.xz().distance(corner1);
@@ -701,7 +859,7 @@ bool World::collide(CollisionSphere& target) const {
         direction = direction * ds;
         targetCenter += vec3{direction.x, 0, direction.y};;
         collided = true;
-      } else if(iternxnz->opaque()) {
+      } else if(opaqueAt(-1, 0, -1)) {
         // not collided, check the other side
         vec2 corner2 = centerxz - delta;
         float distance2 = targetCenter.xz().distance(corner2);
@@ -713,7 +871,7 @@ bool World::collide(CollisionSphere& target) const {
           collided = true;
         }
       }
-    } else if(iternxnz->opaque()) {
+    } else if(opaqueAt(-1, 0, -1)) {
       // not collided, check the other side
       vec2 delta = vec2{.5f, .5f};
       vec2 corner2 = centerxz - delta;
@@ -729,15 +887,10 @@ bool World::collide(CollisionSphere& target) const {
   }
   // xy - const z
   {
-    iterpxpy = iterpx.nextPosY();
-    iterpxny = iterpx.nextNegY();
-    iternxny = iternx.nextNegY();
-    iternxpy = iternx.nextPosY();
-    
     vec2 centerxy = centerPosition.xy();
 
     // 1, 3
-    if(iterpxpy->opaque()){
+    if(opaqueAt(1, 1, 0)){
       vec2 delta = vec2{.5f, .5f};
       vec2 corner1 = centerxy + delta;
       float distance1 = targetCenter.xy().distance(corner1);
@@ -747,7 +900,7 @@ bool World::collide(CollisionSphere& target) const {
         direction = direction * ds;
         targetCenter += vec3{direction.x, direction.y, 0};
         collided = true;
-      } else if(iternxny->opaque()) {
+      } else if(opaqueAt(-1, -1, 0)) {
         // not collided, check the other side
         vec2 corner2 = centerxy - delta;
         float distance2 = targetCenter.xy().distance(corner2);
@@ -761,7 +914,7 @@ bool World::collide(CollisionSphere& target) const {
       }
     } else {
       vec2 delta = vec2{.5f, .5f};
-      if(iternxny->opaque()) {
+      if(opaqueAt(-1, -1, 0)) {
         // not collided, check the other side
         vec2 corner2 = centerxy - delta;
         float distance2 = targetCenter.xy().distance(corner2);
@@ -776,7 +929,7 @@ bool World::collide(CollisionSphere& target) const {
     }
 
     // 2, 4
-    if(iterpxny->opaque()){
+    if(opaqueAt(1, -1, 0)){
       vec2 delta = vec2{.5f, -.5f};
       vec2 corner1 = centerxy + delta;
       float distance1 = targetCenter.xy().distance(corner1);
@@ -786,7 +939,7 @@ bool World::collide(CollisionSphere& target) const {
         direction = direction * ds;
         targetCenter += vec3{direction.x, direction.y, 0};
         collided = true;
-      } else if(iternxpy->opaque()) {
+      } else if(opaqueAt(-1, 1, 0)) {
         // not collided, check the other side
         vec2 corner2 = centerxy - delta;
         float distance2 = targetCenter.xy().distance(corner2);
@@ -799,7 +952,7 @@ bool World::collide(CollisionSphere& target) const {
         }
       }
     } else {
-      if(iternxpy->opaque()) {
+      if(opaqueAt(-1, 1, 0)) {
         // not collided, check the other side
         vec2 delta = vec2{.5f, -.5f};
         vec2 corner2 = centerxy - delta;
@@ -829,22 +982,10 @@ bool World::collide(CollisionSphere& target) const {
    *   |/      |/             x  
    *   7 ----- 6         y___/
    */  
-  Chunk::BlockIter
-    iterpxpypz = iterpxpy.nextPosZ(), // 0
-    iternxnynz = iternxny.nextNegZ(), // 6
-
-    iterpxnypz = iterpxny.nextPosZ(), // 1
-    iternxpynz = iternxpy.nextNegZ(), // 7
-
-    iternxnypz = iternxny.nextPosZ(), // 2
-    iterpxpynz = iterpxpy.nextNegZ(), // 4
-  
-    iternxpypz = iternxpy.nextPosZ(), // 3
-    iterpxnynz = iterpxny.nextNegZ(); // 5
 
   {
     // 0, 6
-    if(iterpxpypz->opaque()) {
+    if(opaqueAt(1, 1, 1)) {
       vec3 delta = vec3{.5f, .5f, .5f};
       vec3 corner1 = centerPosition + delta;
       float distance1 = targetCenter.distance(corner1);
@@ -854,7 +995,7 @@ bool World::collide(CollisionSphere& target) const {
         direction = direction * ds;
         targetCenter += direction;
         collided = true;
-      } else if(iternxnynz->opaque()) {
+      } else if(opaqueAt(-1, -1, -1)) {
         // not collided, check the other side
         vec3 corner2 = centerPosition - delta;
         float distance2 = targetCenter.distance(corner2);
@@ -867,7 +1008,7 @@ bool World::collide(CollisionSphere& target) const {
         }
       }
     } else {
-      if(iternxnynz->opaque()) {
+      if(opaqueAt(-1, -1, -1)) {
         // not collided, check the other side
         vec3 delta = vec3{.5f, .5f, .5f};
         vec3 corner2 = centerPosition - delta;
@@ -885,7 +1026,7 @@ bool World::collide(CollisionSphere& target) const {
 
   {
     // 1, 7
-    if(iterpxnypz->opaque()){
+    if(opaqueAt(1, -1, 1)){
       vec3 delta = vec3{.5f, -.5f, .5f};
       vec3 corner1 = centerPosition + delta;
       float distance1 = targetCenter.distance(corner1);
@@ -895,7 +1036,7 @@ bool World::collide(CollisionSphere& target) const {
         direction = direction * ds;
         targetCenter += direction;
         collided = true;
-      } else if(iternxpynz->opaque()) {
+      } else if(opaqueAt(-1, 1, -1)) {
         // not collided, check the other side
         vec3 corner2 = centerPosition - delta;
         float distance2 = targetCenter.distance(corner2);
@@ -908,7 +1049,7 @@ bool World::collide(CollisionSphere& target) const {
         }
       }
     } else {
-      if(iternxpynz->opaque()) {
+      if(opaqueAt(-1, 1, -1)) {
         // not collided, check the other side
       vec3 delta = vec3{.5f, -.5f, .5f};
         vec3 corner2 = centerPosition - delta;
@@ -926,7 +1067,7 @@ bool World::collide(CollisionSphere& target) const {
 
   {
     // 2, 4
-    if(iternxnypz->opaque()){
+    if(opaqueAt(-1, -1, 1)){
       vec3 delta = vec3{-.5f, -.5f, .5f};
       vec3 corner1 = centerPosition + delta;
       float distance1 = targetCenter.distance(corner1);
@@ -936,7 +1077,7 @@ bool World::collide(CollisionSphere& target) const {
         direction = direction * ds;
         targetCenter += direction;
         collided = true;
-      } else if(iterpxpynz->opaque()) {
+      } else if(opaqueAt(1, 1, -1)) {
         // not collided, check the other side
         vec3 corner2 = centerPosition - delta;
         float distance2 = targetCenter.distance(corner2);
@@ -949,7 +1090,7 @@ bool World::collide(CollisionSphere& target) const {
         }
       }
     } else {
-      if(iterpxpynz->opaque()) {
+      if(opaqueAt(1, 1, -1)) {
         // not collided, check the other side
       vec3 delta = vec3{-.5f, -.5f, .5f};
         vec3 corner2 = centerPosition - delta;
@@ -967,7 +1108,7 @@ bool World::collide(CollisionSphere& target) const {
 
   {
     // 3, 5
-    if(iternxpypz->opaque()){
+    if(opaqueAt(-1, 1, 1)){
       vec3 delta = vec3{-.5f, .5f, .5f};
       vec3 corner1 = centerPosition + delta;
       float distance1 = targetCenter.distance(corner1);
@@ -977,7 +1118,7 @@ bool World::collide(CollisionSphere& target) const {
         direction = direction * ds;
         targetCenter += direction;
         collided = true;
-      } else if(iterpxnynz->opaque()) {
+      } else if(opaqueAt(1, -1, -1)) {
         // not collided, check the other side
         vec3 corner2 = centerPosition - delta;
         float distance2 = targetCenter.distance(corner2);
@@ -990,7 +1131,7 @@ bool World::collide(CollisionSphere& target) const {
         }
       }
     } else {
-      if(iterpxnynz->opaque()) {
+      if(opaqueAt(1, -1, -1)) {
         // not collided, check the other side
         vec3 delta = vec3{-.5f, .5f, .5f};
         vec3 corner2 = centerPosition - delta;
@@ -1024,7 +1165,23 @@ void World::updateChunks() {
   
 }
 
+void World::remeshPlayerEdits() {
+  // only the dirty sections are meshed, small enough to do inline. a job in flight is overtaken,
+  // the sync build takes its sections as well and the job drops its result
+  for(const ChunkCoords& coords: mPriorityRemesh) {
+    Chunk* chunk = findChunk(coords);
+    if(chunk->invalid() || !chunk->isDirty()) continue;
+    // one never meshed is a whole chunk of work, it stays in the regular lane
+    if(!chunk->renderable()) continue;
+    if(chunk->state() == CHUNK_STATE_LOADED_NO_MESH || chunk->state() == CHUNK_STATE_MESH_CONSTRUCTING) {
+      chunk->reconstructMesh();
+    }
+  }
+  mPriorityRemesh.clear();
+}
+
 void World::manageChunks() {
+  remeshPlayerEdits();
 
   uint activatedChunkCount = 0;
   ChunkCoords playerChunkCoords = ChunkCoords::fromWorld(viewPosition());
@@ -1076,7 +1233,8 @@ static void updateBlockLight(const Chunk::BlockIter& iter, std::deque<Chunk::Blo
   uint8_t newOutdoorLight = 0;
 
   uint8_t oldIndoorLight = iter->indoorLight();
-  uint8_t newIndoorLight = iter->type().emissive();
+  uint8_t newIndoorLight = BlockProperties::emissive(iter->id());
+  uint8_t attenuation = BlockProperties::attenuation(iter->id());
 
   Chunk::BlockIter neighbors[6] = {
     iter.nextNegX(),
@@ -1087,7 +1245,7 @@ static void updateBlockLight(const Chunk::BlockIter& iter, std::deque<Chunk::Blo
     iter.nextPosZ()
   };
 
-  bool opaque = iter->opaque();
+  bool opaque = iter.opaque();
   
   // init update outdoor lighting
   Chunk::BlockIter topBlock = neighbors[5];
@@ -1100,13 +1258,13 @@ static void updateBlockLight(const Chunk::BlockIter& iter, std::deque<Chunk::Blo
   if(!opaque) {
     for(auto block: neighbors){
       if(block.valid()) {
-        if(newIndoorLight + 1 < block->indoorLight()) {
-          Block& b = *block;
-          newIndoorLight = b.indoorLight() - 1;
+        if(newIndoorLight + attenuation < block->indoorLight()) {
+          Chunk::BlockRef b = *block;
+          newIndoorLight = b.indoorLight() - attenuation;
         }
-        if(newOutdoorLight + 1 < block->outdoorLight()) {
-          Block& b = *block;
-          uint8_t xx = b.outdoorLight() - 1;
+        if(newOutdoorLight + attenuation < block->outdoorLight()) {
+          Chunk::BlockRef b = *block;
+          uint8_t xx = b.outdoorLight() - attenuation;
           newOutdoorLight = xx;
         }
       }
@@ -1119,9 +1277,10 @@ static void updateBlockLight(const Chunk::BlockIter& iter, std::deque<Chunk::Blo
   if(needToDirtyNeighbors) {
     iter->setIndoorLight(newIndoorLight);
     iter->setOutdoorLight(newOutdoorLight);
-    iter.chunk->setDirty();
+    iter.chunk->setSectionsDirty(Chunk::sectionsShowing(iter.index()));
+    iter.chunk->setVolumeDirty(1u << (BlockCoords::fromIndex(iter.index()).z / Chunk::kSectionSizeZ));
     for(auto block: neighbors) {
-      if(!block->lightDirty() && !block->opaque() && block.valid()) {
+      if(!block->lightDirty() && !block.opaque() && block.valid()) {
         block->setLightDirty();
         pending.push_back(block);
       }
@@ -1163,6 +1322,16 @@ vec3 World::viewPosition() {
 std::vector<ChunkCoords> World::sChunkActivationVisitingPattern{};
 std::vector<ChunkCoords> World::sChunkDeactivationVisitingPattern{};
 
+// squared distance in chunks, a step along z weighs what it is in blocks
+static int visitingDistance2(const ChunkCoords& c) {
+#if CUBIC_CHUNKS
+  int z = c.z * int(Chunk::kSizeZ) / int(Chunk::kSizeX);
+  return c.x * c.x + c.y * c.y + z * z;
+#else
+  return c.magnitude2();
+#endif
+}
+
 void World::reconstructChunkVisitingPattern() {
   int halfRange = (int)floor(Config::kMinDeactivateDistance / float(std::max(Chunk::kSizeY, Chunk::kSizeX)));
 
@@ -1171,31 +1340,47 @@ void World::reconstructChunkVisitingPattern() {
   int activateChunkDist2 = activateChunkDist * activateChunkDist;
   EXPECTS(halfRange > 0);
 
-  sChunkActivationVisitingPattern.reserve(halfRange * halfRange);
-  sChunkDeactivationVisitingPattern.reserve(halfRange * halfRange);
+  // cubic chunks only stream the slabs close to the viewer
+#if CUBIC_CHUNKS
+  int verticalHalfRange = (int)ceil(Config::kMinVerticalDeactivateDistance / float(Chunk::kSizeZ));
+  int activateVerticalDist = (int)floor(Config::kMaxVerticalActivateDistance / float(Chunk::kSizeZ));
+#else
+  int verticalHalfRange = 0;
+  int activateVerticalDist = 0;
+#endif
 
-  for(int j = -halfRange; j < halfRange; ++j) {
-    for(int i = -halfRange; i < halfRange; ++i) {
-      ivec2 coord{i, j};
-      if(coord.magnitude2() <= activateChunkDist2) {
-        sChunkActivationVisitingPattern.emplace_back(coord);
-      } else {
-        sChunkDeactivationVisitingPattern.emplace_back(coord);
+  sChunkActivationVisitingPattern.reserve(halfRange * halfRange * (2 * verticalHalfRange + 1));
+  sChunkDeactivationVisitingPattern.reserve(halfRange * halfRange * (2 * verticalHalfRange + 1));
+
+  for(int k = -verticalHalfRange; k <= verticalHalfRange; ++k) {
+    for(int j = -halfRange; j < halfRange; ++j) {
+      for(int i = -halfRange; i < halfRange; ++i) {
+        ivec2 coord{i, j};
+#if CUBIC_CHUNKS
+        ChunkCoords coords = ivec3{i, j, k};
+#else
+        ChunkCoords coords = coord;
+#endif
+        if(coord.magnitude2() <= activateChunkDist2 && abs(k) <= activateVerticalDist) {
+          sChunkActivationVisitingPattern.emplace_back(coords);
+        } else {
+          sChunkDeactivationVisitingPattern.emplace_back(coords);
+        }
       }
     }
   }
 
   std::sort(sChunkActivationVisitingPattern.begin(), 
             sChunkActivationVisitingPattern.end(), 
-            [](const ivec2& lhs, const ivec2& rhs) {
-    return lhs.magnitude2() < rhs.magnitude2();
+            [](const ChunkCoords& lhs, const ChunkCoords& rhs) {
+    return visitingDistance2(lhs) < visitingDistance2(rhs);
   });
 
   std::sort(sChunkDeactivationVisitingPattern.begin(), 
             sChunkDeactivationVisitingPattern.end(), 
-            [](const ivec2& lhs, const ivec2& rhs) {
-    return lhs.magnitude2() > rhs.magnitude2();
+            [](const ChunkCoords& lhs, const ChunkCoords& rhs) {
+    return visitingDistance2(lhs) > visitingDistance2(rhs);
   });
 
-  ENSURES(sChunkActivationVisitingPattern[0] == ivec2::zero);
-}
\ No newline at end of file
+  ENSURES(sChunkActivationVisitingPattern[0] == chunk_coords_t::zero);
+}
@@ -1,12 +1,14 @@
 ﻿#pragma once
 #include "Engine/Core/common.hpp"
 #include <map>
+#include <atomic>
 #include "Game/World/Chunk.hpp"
 #include "Engine/Graphics/Camera.hpp"
 #include "Game/Gameplay/FollowCamera.hpp"
 #include "Engine/Memory/RingBuffer.hpp"
 #include "Game/Gameplay/Collision.hpp"
 #include "Engine/Async/Job.hpp"
+#include "Game/World/ChunkPool.hpp"
 
 class Chunk;
 class VoxelRenderer;
@@ -38,6 +40,7 @@ struct raycast_result_t {
 };
 
 class World {
+  friend class ChunkBenchmark;
 public:
   void onInit();
   void onInput();
@@ -52,9 +55,21 @@ public:
   Chunk* findChunk(const ChunkCoords& coords) const;
   Chunk* findChunk(const vec3& worldPosition) const;
 
+  // random access by world block coords, anything not loaded reads as `Block::kInvalid`.
+  // the chunk is looked up through the calling thread's last used one and the slot table. jobs may call these
+  // as long as the main thread does not register or unregister chunks meanwhile
+  Block block(const ivec3& worldBlock) const;
+  void blocks(span<const ivec3> worldBlocks, span<Block> out) const;
+
+  uint activeChunkCount() const;
+  size_t activeChunkMemory() const;
+  const ChunkPool::stats_t& chunkPoolStats() const { return mChunkPool.stats(); }
+
   raycast_result_t raycast(const vec3& start, const vec3& dir, float maxDist) const;
 
   void submitDirtyBlock(const Chunk::BlockIter& block);
+  // a block the player changed, its chunk and the neighbors it dirtied are remeshed this frame instead of queueing behind streaming
+  void submitPlayerEdit(const Chunk::BlockIter& block);
 
   owner<Mesh*> aquireDebugLightDirtyMesh() const;
 
@@ -67,20 +82,39 @@ public:
   bool collide(span<CollisionSphere> target) const;
 
 protected:
-  Chunk* allocChunk(ChunkCoords coords) { return new Chunk(coords); }
-  void freeChunk(Chunk* chunk) { delete chunk; } 
+  Chunk* allocChunk(ChunkCoords coords) { return mChunkPool.acquire(coords); }
+  void freeChunk(Chunk* chunk) { mChunkPool.release(chunk); } 
   void registerChunkToWorld(Chunk* chunk);
+  void flushPendingEdits(const ChunkCoords& around);
   owner<Chunk*> unregisterChunkFromWorld(const ChunkCoords& coords);
   vec3 viewPosition();
 
+  // loaded chunks by their coords wrapped to the table size, big enough that the activation range never wraps onto itself.
+  // a slot is only a hint, `cachedChunk` checks the coords and falls back to the map
+#if CUBIC_CHUNKS
+  static constexpr uint kChunkSlotBitXY = 6;
+  static constexpr uint kChunkSlotBitZ = 3;
+#else
+  static constexpr uint kChunkSlotBitXY = 6;
+  static constexpr uint kChunkSlotBitZ = 0;
+#endif
+  static constexpr uint kChunkSlotCount = 1u << (kChunkSlotBitXY * 2 + kChunkSlotBitZ);
+  static uint chunkSlot(const ChunkCoords& coords);
+  Chunk* cachedChunk(const ChunkCoords& coords) const;
+
   void updateChunks();
   void manageChunks();
+  void remeshPlayerEdits();
 
   void propagateLight(bool step);
 
   vec3 mCurrentViewPosition;
+  ChunkPool mChunkPool;
   std::unordered_map<ChunkCoords, Chunk*> mActiveChunks;
+  // lookups refill a slot they missed, from any thread
+  mutable std::array<std::atomic<Chunk*>, kChunkSlotCount> mChunkSlots = {};
   std::vector<ChunkCoords> mLoadingChunks;
+  std::vector<ChunkCoords> mPriorityRemesh;
   std::deque<Chunk::BlockIter> mLightDirtyList;
   mutable std::vector<aabb3> mDebugRayCubes;
   RingBuffer mWeatherNoiseSample;
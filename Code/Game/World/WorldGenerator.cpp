@@ -0,0 +1,66 @@
+#include "WorldGenerator.hpp"
+#include <atomic>
+#include <thread>
+#include "Engine/Async/Job.hpp"
+#include "Game/World/PendingEdits.hpp"
+
+std::vector<ChunkCoords> WorldGenerator::range(const ChunkCoords& mins, const ChunkCoords& maxs) {
+  std::vector<ChunkCoords> coords;
+#if CUBIC_CHUNKS
+  for(int k = mins.z; k <= maxs.z; k++) {
+#else
+  {
+#endif
+    for(int j = mins.y; j <= maxs.y; j++) {
+      for(int i = mins.x; i <= maxs.x; i++) {
+#if CUBIC_CHUNKS
+        coords.push_back(ChunkCoords{ ivec3{ i, j, k } });
+#else
+        coords.push_back(ChunkCoords{ i, j });
+#endif
+      }
+    }
+  }
+  return coords;
+}
+
+void WorldGenerator::generate(Chunk& chunk) const {
+  chunk.generateBlocks(mSeed);
+}
+
+void WorldGenerator::generate(span<Chunk* const> chunks, uint jobCount) const {
+  if(chunks.size() == 0) return;
+
+  if(jobCount == 0) jobCount = std::max(1u, std::thread::hardware_concurrency());
+  jobCount = std::min(jobCount, uint(chunks.size()));
+
+  // the batch's own store, what the jobs push into it only counts after all of them are done
+  PendingEdits overflow;
+
+  // job i takes every jobCount-th chunk from i, so the surface heavy and the empty ones spread out evenly
+  std::atomic<uint> finished = 0;
+  for(uint i = 0; i < jobCount; i++) {
+    S<Job::Counter> job = Job::create({[this, chunks, i, jobCount, &finished, &overflow] {
+      for(size_t c = i; c < chunks.size(); c += jobCount) {
+        chunks[c]->generateTerrain(mSeed, overflow);
+      }
+      finished++;
+    }}, Job::CAT_GENERIC);
+    Job::dispatch(job);
+  }
+
+  Job::Consumer consumer;
+  Job::category_t cats[] = { Job::CAT_GENERIC };
+  consumer.init(cats);
+  while(finished.load() < jobCount) {
+    if(!consumer.consumeJob()) std::this_thread::yield();
+  }
+
+  // every edit of the batch is in by now, in batch order so no chunk sees a partial set
+  for(Chunk* chunk: chunks) {
+    std::vector<block_edit_t> pending = chunk->takeNewEdits(overflow);
+    chunk->applyEdits(pending);
+    chunk->endBulkWrite();
+    chunk->mState = CHUNK_STATE_LOADED_NO_MESH;
+  }
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "Engine/Core/common.hpp"
+#include "Game/World/Chunk.hpp"
+
+// generates chunks from a world seed. a chunk only depends on the seed and its own coords, never on other
+// chunks, the thread it runs on or the order, so a batch splits across the job system any way it likes.
+// trees crossing into a neighbor are the exception, a batch keeps those to itself and applies them once
+// all its chunks are generated
+class WorldGenerator {
+public:
+  explicit WorldGenerator(uint seed): mSeed(seed) {}
+
+  uint seed() const { return mSeed; }
+
+  // coords of the box mins..maxs, both inclusive, x fastest
+  static std::vector<ChunkCoords> range(const ChunkCoords& mins, const ChunkCoords& maxs);
+
+  // on its own, with the edits the neighbors parked in `PendingEdits::get()` so far
+  void generate(Chunk& chunk) const;
+
+  // generates every chunk in `jobCount` generic jobs, 0 is one per hardware thread. blocks until they are
+  // all done, the calling thread consumes generic jobs meanwhile. chunks must not be in a world yet.
+  // edits between the chunks of the batch are applied, ones for chunks outside of it are dropped
+  void generate(span<Chunk* const> chunks, uint jobCount = 0) const;
+
+protected:
+  uint mSeed;
+};